@@ -0,0 +1,78 @@
+#version 430 core
+
+// clustered forward shading, runs after a depth prepass
+
+layout (location = 0) out vec4 outColor;
+// bright part for bloom and log luminance, only while the shaded image has the attachment enabled
+layout (location = 1) out vec4 outBright;
+
+in vec2 exTexcoord;
+in vec3 exNormal;
+in vec4 exPosition;
+in mat3 exTBN;
+
+layout(shared) uniform SharedMatrices
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
+
+uniform vec3 viewPos;
+
+#include "material.glsl"
+#include "brdf.glsl"
+#include "ibl.glsl"
+#include "lights.glsl"
+#include "clusters.glsl"
+#include "viewport.glsl"
+#include "brightpass.glsl"
+
+// per cluster: light count followed by up to MAX_LIGHTS_PER_CLUSTER light indices
+layout (std430, binding = 1) readonly buffer ClusterLightBuffer
+{
+    uint clusterLightIndices[];
+};
+
+void main()
+{
+    Surface surface = sampleSurface(exTexcoord, exTBN);
+
+    vec3 n = surface.normal;
+    vec3 position = exPosition.xyz;
+
+    // gamma correct albedo to get into linear space
+    vec3 albedo = pow(surface.albedo, vec3(2.2));
+
+    // view vector
+    vec3 w_0 = normalize(viewPos - position);
+
+    // base reflectivity considering metallic
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, surface.metallic);
+
+    // direct lighting, only the lights of this fragment's cluster
+    vec3 L_0 = vec3(0.0);
+
+    float viewDepth = -(ViewMatrix * vec4(position, 1.0)).z;
+    uint clusterOffset = clusterIndex(gl_FragCoord.xy / viewportSize, viewDepth) * (MAX_LIGHTS_PER_CLUSTER + 1);
+    uint clusterLightCount = clusterLightIndices[clusterOffset];
+
+    for(uint i = 0; i < clusterLightCount; ++i)
+    {
+        Light light = lights[clusterLightIndices[clusterOffset + 1 + i]];
+        vec3 w_i = light.position - position;
+        float distance = length(w_i);
+        vec3 L_i = light.color * windowedAttenuation(distance, light.radius);
+
+        L_0 += directLighting(n, w_0, w_i / distance, L_i, albedo, F0, surface.metallic, surface.roughness);
+    }
+
+    // image based lighting
+    vec3 ambient = ambientLighting(n, w_0, albedo, F0, surface.metallic, surface.roughness, surface.ao);
+
+    vec3 color = L_0 + ambient;
+
+    // stays linear HDR, the composite tone maps
+    outColor = vec4(color, 1.0);
+    outBright = brightPass(color);
+}
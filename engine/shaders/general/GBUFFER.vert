@@ -10,6 +10,9 @@ out vec3 exNormal;
 out vec4 exPosition;
 out mat3 exTBN;
 
+// bit identical to the depth prepass, which the geometry pass then tests with GL_EQUAL against
+invariant gl_Position;
+
 uniform mat4 ModelMatrix;
 uniform mat3 NormalMatrix;
 
@@ -0,0 +1,83 @@
+// Cook-Torrance BRDF shared by the lighting shaders
+
+const float PI = 3.14159265359;
+
+// normal distribution function
+float trowbridgeReitzGGX(vec3 N, vec3 H, float roughness)
+{
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH * NdotH;
+	
+    float num = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+	
+    return num / denom;
+}
+
+// used within geometry function
+float geometrySchlickGGX(float NdotV, float roughness)
+{
+    float r = (roughness + 1.0);
+    float k = (r * r) / 8.0;
+
+    float num = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+	
+    return num / denom;
+}
+
+// geometry function
+float geometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx1  = geometrySchlickGGX(NdotL, roughness);
+    float ggx2  = geometrySchlickGGX(NdotV, roughness);	
+    return ggx1 * ggx2;
+}
+
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
+{
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(max(1.0 - cosTheta, 0.0), 5.0);
+}
+
+// reflected radiance of a single light with incoming radiance L_i
+vec3 directLighting(vec3 n, vec3 w_0, vec3 w_i, vec3 L_i, vec3 albedo, vec3 F0, float metallic, float roughness)
+{
+    vec3 h = normalize(w_0 + w_i); // halfway vector
+
+    // specular component
+    float NDF = trowbridgeReitzGGX(n, h, roughness);
+    float G = geometrySmith(n, w_0, w_i, roughness);
+    vec3 F = fresnelSchlick(max(dot(h, w_0), 0.0), F0);
+
+    vec3 kS = F;
+    vec3 numerator    = NDF * G * F;
+    float denominator = 4.0 * max(dot(n, w_0), 0.0) * max(dot(n, w_i), 0.0);
+    vec3 specular     = numerator / max(denominator, 0.001);
+
+    // diffuse component
+    vec3 kD = (vec3(1.0) - kS) * (1.0 - metallic);
+    vec3 diffuse = kD * albedo / PI;
+
+    // calculate BRDF
+    vec3 BRDF = diffuse + specular;
+
+    return BRDF * L_i * max(dot(n, w_i), 0.0);
+}
+
+// inverse square falloff windowed to reach zero at the light radius
+float windowedAttenuation(float distance, float radius)
+{
+    float ratio = distance / radius;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window / max(distance * distance, 0.0001);
+}
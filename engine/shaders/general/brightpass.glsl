@@ -0,0 +1,19 @@
+// Bright part of the linear HDR color that bloom spreads, written next to the shaded color by the lighting passes so
+// bloom does not threshold the image again. The log luminance goes along, averaged over the image it is the exposure.
+uniform float bloomThreshold;
+
+// soft knee, colors fade in over half the threshold below it
+vec3 brightPart(vec3 color)
+{
+    float brightness = max(color.r, max(color.g, color.b));
+    float knee = 0.5 * bloomThreshold;
+    float soft = clamp(brightness - bloomThreshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 1e-4);
+    return color * max(soft, brightness - bloomThreshold) / max(brightness, 1e-4);
+}
+
+// the bright part and the base 2 logarithm of the luminance of a shaded color
+vec4 brightPass(vec3 color)
+{
+    return vec4(brightPart(color), log2(max(dot(color, vec3(0.2126, 0.7152, 0.0722)), 1e-4)));
+}
\ No newline at end of file
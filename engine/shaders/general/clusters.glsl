@@ -0,0 +1,18 @@
+// froxel grid: CLUSTER_COUNT_X x CLUSTER_COUNT_Y screen tiles, CLUSTER_COUNT_Z exponential depth slices
+
+uniform float clusterZNear;
+uniform float clusterZFar;
+
+// view space distance of the near plane of a depth slice
+float clusterSliceDepth(uint slice)
+{
+    return clusterZNear * pow(clusterZFar / clusterZNear, float(slice) / float(CLUSTER_COUNT_Z));
+}
+
+uint clusterIndex(vec2 screenUv, float viewDepth)
+{
+    float slice = log(viewDepth / clusterZNear) / log(clusterZFar / clusterZNear) * float(CLUSTER_COUNT_Z);
+    uint z = uint(clamp(slice, 0.0, float(CLUSTER_COUNT_Z - 1)));
+    uvec2 xy = min(uvec2(screenUv * vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y)), uvec2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1));
+    return (z * CLUSTER_COUNT_Y + xy.y) * CLUSTER_COUNT_X + xy.x;
+}
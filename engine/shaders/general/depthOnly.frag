@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth prepass, only the depth buffer is written
+void main()
+{
+}
@@ -0,0 +1,12 @@
+#version 330 core
+
+// depth prepass, only the depth buffer is written and alpha tested materials are cut out
+
+in vec2 exTexcoord;
+
+#include "material.glsl"
+
+void main()
+{
+	alphaTest(exTexcoord);
+}
\ No newline at end of file
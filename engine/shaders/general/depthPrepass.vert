@@ -0,0 +1,23 @@
+#version 330 core
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec2 inTexcoord;
+
+out vec2 exTexcoord;
+
+uniform mat4 ModelMatrix;
+
+layout(shared) uniform SharedMatrices
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
+
+// must match the position computation of GBUFFER.vert, the passes after the prepass test with GL_EQUAL
+invariant gl_Position;
+
+void main(void)
+{
+	exTexcoord = inTexcoord;
+	gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(inPosition, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+// GBuffer access for every pass writing or reading it, the layout defines come from GBuffer::getShaderDefines:
+// GBUFFER_OCTAHEDRAL_NORMALS   the normal is octahedral encoded into the red and green channel
+// GBUFFER_AO_IN_ALBEDO         ambient occlusion is stored in the alpha channel of the albedo target
+// GBUFFER_MATERIAL_IN_NORMAL   roughness and metallic follow the normal in the blue and alpha channel,
+//                              there is no metallic/roughness/AO target
+// world positions are reconstructed from depth instead of a position target, InverseViewProjectionMatrix is set every frame
+// texture coordinates address the targets, which may be larger than the viewport
+
+#include "viewport.glsl"
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gMetallicRoughnessAO;
+uniform sampler2D gDepth;
+uniform mat4 InverseViewProjectionMatrix;
+
+// same values the position target held: w is 1 on geometry and the background is all zero
+vec4 gbufferPosition(vec2 texcoord)
+{
+    float depth = texture(gDepth, texcoord).r;
+    if (depth == 1.0)
+    {
+        return vec4(0.0);
+    }
+
+    vec4 position = InverseViewProjectionMatrix * vec4(vec3(texcoordToScreen(texcoord), depth) * 2.0 - 1.0, 1.0);
+    return vec4(position.xyz / position.w, 1.0);
+}
+
+// unit vector projected onto the octahedron |x| + |y| + |z| = 1, the lower half folded over the upper one, mapped to [0, 1]
+vec2 encodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 encoded = n.xy;
+    if (n.z < 0.0)
+    {
+        encoded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return encoded * 0.5 + 0.5;
+}
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+    encoded = encoded * 2.0 - 1.0;
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
+// values of the albedo and normal targets, channels the layout does not store are dropped by the target format
+vec4 encodeAlbedo(vec3 albedo, float ao)
+{
+    return vec4(albedo, ao);
+}
+
+vec4 encodeNormal(vec3 normal, float metallic, float roughness)
+{
+#ifdef GBUFFER_OCTAHEDRAL_NORMALS
+    // a 2 bit alpha channel keeps metallic at 0, 1/3, 2/3 or 1
+    return vec4(encodeOctahedral(normal), roughness, metallic);
+#else
+    return vec4(normal, 0.0);
+#endif
+}
+
+vec3 gbufferAlbedo(vec2 texcoord)
+{
+    return texture(gAlbedo, texcoord).rgb;
+}
+
+vec3 gbufferNormal(vec2 texcoord)
+{
+#ifdef GBUFFER_OCTAHEDRAL_NORMALS
+    return decodeOctahedral(texture(gNormal, texcoord).rg);
+#else
+    return texture(gNormal, texcoord).rgb;
+#endif
+}
+
+// metallic, roughness and ambient occlusion wherever the layout keeps them
+vec3 gbufferMetallicRoughnessAO(vec2 texcoord)
+{
+#ifdef GBUFFER_MATERIAL_IN_NORMAL
+    vec2 metallicRoughness = texture(gNormal, texcoord).ab;
+#else
+    vec2 metallicRoughness = texture(gMetallicRoughnessAO, texcoord).rg;
+#endif
+
+#ifdef GBUFFER_AO_IN_ALBEDO
+    float ao = texture(gAlbedo, texcoord).a;
+#else
+    float ao = texture(gMetallicRoughnessAO, texcoord).b;
+#endif
+
+    return vec3(metallicRoughness, ao);
+}
\ No newline at end of file
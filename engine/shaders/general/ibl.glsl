@@ -0,0 +1,24 @@
+// image based lighting, needs brdf.glsl
+
+uniform samplerCube irradianceMap;
+uniform samplerCube prefilterMap;
+uniform sampler2D   brdfLUT;
+
+vec3 ambientLighting(vec3 n, vec3 w_0, vec3 albedo, vec3 F0, float metallic, float roughness, float ao)
+{
+    vec3 F = fresnelSchlickRoughness(max(dot(n, w_0), 0.0), F0, roughness);
+
+    vec3 kS = F;
+    vec3 kD = 1.0 - kS;
+    kD *= 1.0 - metallic;
+
+    vec3 diffuse = texture(irradianceMap, n).rgb * albedo;
+
+    const float MAX_REFLECTION_LOD = 4.0;
+    vec3 R = reflect(-w_0, n);
+    vec3 prefilteredColor = textureLod(prefilterMap, R,  roughness * MAX_REFLECTION_LOD).rgb;   
+    vec2 envBRDF  = texture(brdfLUT, vec2(max(dot(n, w_0), 0.0), roughness)).rg;
+    vec3 specular = prefilteredColor * (F * envBRDF.r + envBRDF.g);
+
+    return (kD * diffuse + specular) * ao;
+}
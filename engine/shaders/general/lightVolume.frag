@@ -0,0 +1,42 @@
+#version 430 core
+
+// direct lighting of a single light, blended additively in linear HDR
+layout (location = 0) out vec4 outColor;
+
+flat in int exLightIndex;
+
+// GBuffer
+#include "gbuffer.glsl"
+
+uniform vec3 viewPos;
+
+#include "lights.glsl"
+#include "brdf.glsl"
+
+void main()
+{
+    vec2 texcoord = gl_FragCoord.xy / vec2(textureSize(gDepth, 0));
+    vec3 position = gbufferPosition(texcoord).xyz;
+
+    Light light = lights[exLightIndex];
+    vec3 w_i = light.position - position;
+    float distance = length(w_i);
+
+    // the stencil only rejects pixels outside of every volume
+    if (position == vec3(0.0) || distance >= light.radius)
+    {
+        discard;
+    }
+
+    vec3 n = gbufferNormal(texcoord);
+    vec3 albedo = pow(gbufferAlbedo(texcoord), vec3(2.2));
+    vec2 metallicRoughness = gbufferMetallicRoughnessAO(texcoord).rg;
+    float metallic = metallicRoughness.r;
+    float roughness = metallicRoughness.g;
+
+    vec3 w_0 = normalize(viewPos - position);
+    vec3 F0 = mix(vec3(0.04), albedo, metallic);
+
+    vec3 L_i = light.color * windowedAttenuation(distance, light.radius);
+    outColor = vec4(directLighting(n, w_0, w_i / distance, L_i, albedo, F0, metallic, roughness), 0.0);
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 430 core
+
+// bounding sphere of a light, one instance per light in the light buffer
+layout (location = 0) in vec3 inPosition;
+
+layout(shared) uniform SharedMatrices
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
+
+#include "lights.glsl"
+
+flat out int exLightIndex;
+
+void main()
+{
+    Light light = lights[gl_InstanceID];
+    exLightIndex = gl_InstanceID;
+
+    vec3 position = light.position + inPosition * light.radius;
+    gl_Position = ProjectionMatrix * ViewMatrix * vec4(position, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+// light data written by LightBuffer, type matches LightType and every light is evaluated as a point light so far
+
+struct Light
+{
+    vec3 position;
+    float radius;
+    vec3 color;
+    uint type;
+};
+
+layout (std430, binding = 0) readonly buffer LightBuffer
+{
+    Light lights[];
+};
\ No newline at end of file
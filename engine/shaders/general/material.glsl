@@ -0,0 +1,64 @@
+// material inputs, set by Material::bind
+
+uniform sampler2D texAlbedo;
+uniform sampler2D texNormal;
+uniform sampler2D texRoughness;
+uniform sampler2D texMetallic;
+uniform sampler2D texAO;
+
+uniform vec3 albedo;
+uniform vec3 normal;
+uniform float roughness;
+uniform float metallic;
+uniform float ao;
+
+uniform bool useAlbedoTex;
+uniform bool useNormalTex;
+uniform bool useRoughnessTex;
+uniform bool useMetallicTex;
+uniform bool useAoTex;
+
+uniform bool useAlphaTest;
+uniform float alphaCutoff;
+
+// the visibility buffer resolve has no screen space derivatives and defines this with explicit gradients
+#ifndef sampleMaterial
+#define sampleMaterial(sampler, texcoord) texture(sampler, texcoord)
+#endif
+
+struct Surface
+{
+    vec3 albedo;
+    vec3 normal;
+    float metallic;
+    float roughness;
+    float ao;
+};
+
+// cut out texels, e.g. of foliage, are discarded
+void alphaTest(vec2 exTexcoord)
+{
+    if (useAlphaTest && sampleMaterial(texAlbedo, vec2(exTexcoord.x, 1 - exTexcoord.y)).a < alphaCutoff)
+    {
+        discard;
+    }
+}
+
+Surface sampleSurface(vec2 exTexcoord, mat3 TBN)
+{
+    Surface surface;
+
+    // invert texcoord y
+    vec2 texcoord = vec2(exTexcoord.x, 1 - exTexcoord.y);
+
+    surface.albedo = useAlbedoTex ? sampleMaterial(texAlbedo, texcoord).rgb : albedo;
+
+    surface.metallic = useMetallicTex ? sampleMaterial(texMetallic, texcoord).r : metallic;
+    surface.roughness = useRoughnessTex ? sampleMaterial(texRoughness, texcoord).r : roughness;
+    surface.ao = useAoTex ? sampleMaterial(texAO, texcoord).r : ao;
+
+    vec3 normalTemp = useNormalTex ? sampleMaterial(texNormal, texcoord).rgb * 2.0 - 1.0 : normal; // map into range [-1, 1]
+    surface.normal = normalize(TBN * normalTemp);
+
+    return surface;
+}
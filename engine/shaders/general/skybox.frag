@@ -2,7 +2,13 @@
 in vec3 exTexcoord;
 
 layout (location = 0) out vec4 outColor;
+// bright part for bloom and log luminance, only while the shaded image has the attachment enabled
+layout (location = 1) out vec4 outBright;
 
+#include "tonemap.glsl"
+#include "brightpass.glsl"
+
+// HDR cubemaps are tone mapped with the frame, LDR ones are expanded so the composite reproduces them
 uniform bool toneMap = false;
 uniform samplerCube cubemap;
 
@@ -10,12 +16,11 @@ void main()
 {
     vec3 color = texture(cubemap, exTexcoord).rgb;
 
-    if (toneMap) {
-        color = color / (color + 1.0);
-        outColor = vec4(pow(color, vec3(1.0/2.2)), 1);
-    } else {    
-        outColor = vec4(color, 1.0);
+    if (!toneMap) {
+        color = inverseTonemap(color);
     }
+    outColor = vec4(color, 1.0);
+    outBright = brightPass(color);
     
     gl_FragDepth = 1.0;
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 430 core
+
+// a quad per instance over a tile of a TileClassification list, drawn instead of the full screen quad of quad2D.vert
+// by passes that only have work on some tiles, CLASSIFICATION_TILE_SIZE is defined by TileClassification
+out vec2 exTexcoord;
+
+#include "viewport.glsl"
+
+// tile coordinates of the list, x in the lower and y in the upper 16 bits
+layout (std430, binding = 5) readonly buffer TileList
+{
+    uint tiles[];
+};
+
+const vec2 CORNERS[6] = vec2[6](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main()
+{
+    uint tile = tiles[gl_InstanceID];
+    vec2 pixel = (vec2(tile & 0xffffu, tile >> 16) + CORNERS[gl_VertexID]) * float(CLASSIFICATION_TILE_SIZE);
+    // tiles on the right and top edge end with the viewport
+    vec2 screenUv = min(pixel / viewportSize, 1.0);
+    exTexcoord = screenToTexcoord(screenUv);
+    gl_Position = vec4(screenUv * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+// Reinhard tone mapping and gamma correction, the frame stays linear HDR until the composite applies it once
+vec3 tonemap(vec3 color)
+{
+    color = color / (color + vec3(1.0));
+    return pow(color, vec3(1.0/2.2));
+}
+
+// display referred colors expanded to the HDR values tonemap maps to them, white is limited to a finite value
+vec3 inverseTonemap(vec3 color)
+{
+    color = min(pow(color, vec3(2.2)), vec3(0.995));
+    return color / (vec3(1.0) - color);
+}
\ No newline at end of file
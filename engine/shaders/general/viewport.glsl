@@ -0,0 +1,24 @@
+// Screen sized targets are allocated in buckets larger than the window and only their bottom left viewport is rendered.
+// Texture coordinates of full screen passes address the targets, screen coordinates span the viewport from 0 to 1.
+// The block is filled by ScreenViewport.
+layout (std140, binding = 1) uniform ScreenViewport
+{
+    vec2 viewportSize;  // in pixels
+    vec2 viewportScale; // viewport size / target size, the texture coordinate of the top right viewport corner
+};
+
+vec2 screenToTexcoord(vec2 screenUv)
+{
+    return screenUv * viewportScale;
+}
+
+vec2 texcoordToScreen(vec2 texcoord)
+{
+    return texcoord / viewportScale;
+}
+
+// keeps filter taps inside the viewport, like clamping to the edge of a target the size of the window
+vec2 clampToViewport(vec2 texcoord, vec2 texelSize)
+{
+    return min(texcoord, viewportScale - 0.5 * texelSize);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 430 core
+
+layout (location = 0) out uint outId;
+
+uniform int drawIndex;
+
+in vec2 exTexcoord;
+
+#include "material.glsl"
+
+void main()
+{
+    alphaTest(exTexcoord);
+
+    // gl_PrimitiveID counts the triangles of the current draw call
+    outId = (uint(drawIndex) << TRIANGLE_BITS) | uint(gl_PrimitiveID);
+}
\ No newline at end of file
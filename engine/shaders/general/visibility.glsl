@@ -0,0 +1,34 @@
+// visibility buffer ids and draw records, TRIANGLE_BITS and MAX_MESHES are defined by VisibilityBuffer
+// an id holds the draw in its upper bits and the triangle of the draw's mesh in the lower TRIANGLE_BITS
+
+const uint EMPTY_ID = 0xFFFFFFFFu;
+
+struct DrawRecord
+{
+    mat4 modelMatrix;
+    // upper 3x3 is the normal matrix
+    mat4 normalMatrix;
+    // index of the mesh in the resolve order
+    uint mesh;
+};
+
+layout (std430, binding = 2) readonly buffer DrawBuffer
+{
+    DrawRecord draws[];
+};
+
+uint visibilityDraw(uint id)
+{
+    return id >> TRIANGLE_BITS;
+}
+
+uint visibilityTriangle(uint id)
+{
+    return id & ((1u << TRIANGLE_BITS) - 1u);
+}
+
+// distinct depth per mesh, exactly representable so the classification and the resolve quads compare equal
+float meshDepth(uint mesh)
+{
+    return float(mesh + 1u) / float(MAX_MESHES + 1);
+}
\ No newline at end of file
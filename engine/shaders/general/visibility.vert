@@ -0,0 +1,21 @@
+#version 430 core
+
+// positions and the texcoords for alpha testing only, every other attribute is fetched when resolving
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec2 inTexcoord;
+
+out vec2 exTexcoord;
+
+uniform mat4 ModelMatrix;
+
+layout(shared) uniform SharedMatrices
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
+
+void main(void)
+{
+	exTexcoord = inTexcoord;
+	gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(inPosition, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 430 core
+
+// writes the mesh of every covered pixel as depth, so the resolve can shade each mesh with an early depth test
+
+uniform usampler2D visibilityIds;
+
+#include "visibility.glsl"
+
+void main()
+{
+    uint id = texelFetch(visibilityIds, ivec2(gl_FragCoord.xy), 0).r;
+    if (id == EMPTY_ID)
+    {
+        discard;
+    }
+
+    gl_FragDepth = meshDepth(draws[visibilityDraw(id)].mesh);
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#version 430 core
+
+// rebuilds the surface of every pixel from its triangle and writes it into the GBuffer like GBUFFER.frag,
+// VERTEX_STRIDE and the attribute offsets are given in floats of the Vertex struct
+layout (location = 0) out vec4 AlbedoOut;
+layout (location = 1) out vec4 NormalOut;
+layout (location = 2) out vec4 MetallicRoughnessAOOut;
+
+uniform usampler2D visibilityIds;
+
+#include "visibility.glsl"
+
+// buffers of the mesh currently resolved
+layout (std430, binding = 3) readonly buffer VertexBuffer
+{
+    float vertexData[];
+};
+
+layout (std430, binding = 4) readonly buffer IndexBuffer
+{
+    uint indices[];
+};
+
+layout(shared) uniform SharedMatrices
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
+
+// texture coordinate gradients for the material lookups, set before sampleSurface
+vec2 texcoordDdx = vec2(0.0);
+vec2 texcoordDdy = vec2(0.0);
+#define sampleMaterial(sampler, texcoord) textureGrad(sampler, texcoord, texcoordDdx, texcoordDdy)
+
+#include "material.glsl"
+#include "gbuffer.glsl"
+
+vec3 vertexAttribute(uint vertex, int offset)
+{
+    uint base = vertex * VERTEX_STRIDE + offset;
+    return vec3(vertexData[base], vertexData[base + 1], vertexData[base + 2]);
+}
+
+// perspective correct barycentrics of the pixel and their screen space derivatives
+struct Barycentrics
+{
+    vec3 lambda;
+    vec3 ddx;
+    vec3 ddy;
+};
+
+Barycentrics barycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 pixelNdc, vec2 screenSize)
+{
+    Barycentrics result;
+
+    vec3 invW = 1.0 / vec3(clip0.w, clip1.w, clip2.w);
+    vec2 ndc0 = clip0.xy * invW.x;
+    vec2 ndc1 = clip1.xy * invW.y;
+    vec2 ndc2 = clip2.xy * invW.z;
+
+    // screen space barycentrics divided by w are linear in ndc
+    float invDet = 1.0 / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+    vec3 ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+    vec3 ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+    float ddxSum = dot(ddx, vec3(1.0));
+    float ddySum = dot(ddy, vec3(1.0));
+
+    vec2 delta = pixelNdc - ndc0;
+    float interpolatedInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+    result.lambda = (vec3(invW.x, 0.0, 0.0) + delta.x * ddx + delta.y * ddy) / interpolatedInvW;
+
+    // one pixel step in ndc
+    vec2 pixelSize = 2.0 / screenSize;
+    ddx *= pixelSize.x;
+    ddy *= pixelSize.y;
+    ddxSum *= pixelSize.x;
+    ddySum *= pixelSize.y;
+
+    result.ddx = (result.lambda * interpolatedInvW + ddx) / (interpolatedInvW + ddxSum) - result.lambda;
+    result.ddy = (result.lambda * interpolatedInvW + ddy) / (interpolatedInvW + ddySum) - result.lambda;
+    return result;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    uint id = texelFetch(visibilityIds, pixel, 0).r;
+    DrawRecord draw = draws[visibilityDraw(id)];
+    uint triangle = visibilityTriangle(id);
+
+    uint vertices[3] = uint[3](indices[triangle * 3u], indices[triangle * 3u + 1u], indices[triangle * 3u + 2u]);
+
+    mat4 modelViewProjection = ProjectionMatrix * ViewMatrix * draw.modelMatrix;
+    vec4 clip[3];
+    for (int i = 0; i < 3; i++)
+    {
+        clip[i] = modelViewProjection * vec4(vertexAttribute(vertices[i], 0), 1.0);
+    }
+
+    Barycentrics bary = barycentrics(clip[0], clip[1], clip[2], gl_FragCoord.xy / viewportSize * 2.0 - 1.0, viewportSize);
+
+    // same per vertex tangent frame as GBUFFER.vert, interpolated
+    mat3 normalMatrix = mat3(draw.normalMatrix);
+    vec2 texcoords[3];
+    mat3 TBN = mat3(0.0);
+    for (int i = 0; i < 3; i++)
+    {
+        uint base = vertices[i] * VERTEX_STRIDE + TEXCOORD_OFFSET;
+        texcoords[i] = vec2(vertexData[base], vertexData[base + 1]);
+
+        vec3 T = normalize(normalMatrix * vertexAttribute(vertices[i], TANGENT_OFFSET));
+        vec3 N = normalize(normalMatrix * vertexAttribute(vertices[i], NORMAL_OFFSET));
+        vec3 B = normalize(normalMatrix * cross(N, T));
+        TBN += mat3(T, B, N) * bary.lambda[i];
+    }
+
+    mat3x2 texcoordMatrix = mat3x2(texcoords[0], texcoords[1], texcoords[2]);
+    vec2 texcoord = texcoordMatrix * bary.lambda;
+    texcoordDdx = texcoordMatrix * bary.ddx;
+    texcoordDdy = texcoordMatrix * bary.ddy;
+
+    Surface surface = sampleSurface(texcoord, TBN);
+
+    AlbedoOut = encodeAlbedo(surface.albedo, surface.ao);
+    MetallicRoughnessAOOut = vec4(surface.metallic, surface.roughness, surface.ao, 0.0);
+    NormalOut = encodeNormal(surface.normal, surface.metallic, surface.roughness);
+}
\ No newline at end of file
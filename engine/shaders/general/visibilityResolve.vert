@@ -0,0 +1,13 @@
+#version 430 core
+
+// full screen quad at the depth of one mesh, GL_EQUAL leaves only the pixels showing that mesh
+layout (location = 0) in vec3 inPosition;
+
+uniform int meshIndex;
+
+#include "visibility.glsl"
+
+void main()
+{
+	gl_Position = vec4(inPosition.xy, meshDepth(uint(meshIndex)) * 2.0 - 1.0, 1.0);
+}
\ No newline at end of file
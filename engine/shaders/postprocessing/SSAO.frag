@@ -1,10 +1,9 @@
-#version 410 core
+#version 420 core
 out vec3 FragColor;
 
 in vec2 exTexcoord;
 
-uniform sampler2D gPosition;
-uniform sampler2D gNormal;
+#include "../general/gbuffer.glsl"
 uniform sampler2D texNoise;
 
 layout(shared) uniform SharedMatrices
@@ -15,6 +14,11 @@ layout(shared) uniform SharedMatrices
 
 
 uniform vec3 samples[64];
+// every kernelStride-th sample from kernelOffset on, the reduced resolution modes spread the kernel over several frames
+uniform int kernelStride;
+uniform int kernelOffset;
+// rotates the noise pattern between frames, in noise texels
+uniform vec2 noiseOffset;
 
 uniform vec3 viewPos;
 
@@ -26,20 +30,17 @@ uniform int kernelSize;
 void main()
 {   
     
-    vec2 texSize = textureSize(gPosition, 0);
-    vec2 noiseScale = texSize/4.0;
-    
     // get Fragment Position in World Space
-    vec4 fragPos = vec4(texture(gPosition, exTexcoord));
+    vec4 fragPos = gbufferPosition(exTexcoord);
     // transform to View Space
     fragPos = ViewMatrix * fragPos;
 
     // get View Space Normals
-    vec3 normal = normalize(texture(gNormal, exTexcoord).rgb);
+    vec3 normal = gbufferNormal(exTexcoord);
     normal = vec3(transpose(inverse(ViewMatrix)) * vec4(normal,1)).xyz;
 
     // calculate random direction
-    vec3 randomVec = normalize(texture(texNoise, exTexcoord * noiseScale).xyz);
+    vec3 randomVec = normalize(texture(texNoise, (gl_FragCoord.xy + noiseOffset) / 4.0).xyz);
 
     // calculate TBN 
     vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
@@ -60,7 +61,7 @@ void main()
         }
 
         // get sample position
-        samplePos = TBN * samples[i]; 
+        samplePos = TBN * samples[(i * kernelStride + kernelOffset) % 64]; 
         samplePos = fragPos.xyz + samplePos * radius; 
         
         // calclate texture coordinates for sample position
@@ -70,7 +71,7 @@ void main()
         offset.xyz = offset.xyz * 0.5 + 0.5; 
         
         // get Position in World Space
-        offsetPosition = texture(gPosition, offset.xy);
+        offsetPosition = gbufferPosition(screenToTexcoord(offset.xy));
         vec4 testPosition = offsetPosition;
 
         // to View Space
@@ -97,5 +98,6 @@ void main()
     int leftOver = kernelSize - rejectedSamples;
     occlusion = (leftOver <= 0) ? 1.0 : (1.0 - (occlusion / leftOver));
     
-    FragColor = vec3(occlusion);
+    // linear depth for the temporal accumulation and the upsampling, zero on the background
+    FragColor = vec3(occlusion, -fragPos.z, 0.0);
 }
\ No newline at end of file
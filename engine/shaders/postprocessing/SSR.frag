@@ -1,13 +1,10 @@
-#version 330 core
+#version 420 core
 
 out vec4 fragColor;
 
-uniform sampler2D gPosition;
-uniform sampler2D gNormal;
+#include "../general/gbuffer.glsl"
 uniform sampler2D gShaded;
-uniform sampler2D gMetallicRoughnessAO;
 
-uniform vec2 gScreenSize;
 uniform vec3 viewPos;
 
 uniform float maxRayDistance;
@@ -26,7 +23,8 @@ in vec2 exTexcoord;
 void main() {
 	
 	
-    vec2 texSize  = textureSize(gShaded, 0).xy;
+    // the ray is marched in viewport pixels, texPos holds screen coordinates
+    vec2 texSize = viewportSize;
 
 	// defines number of refinement search steps
 	int searchSteps = 10;
@@ -39,9 +37,10 @@ void main() {
 	vec4 finalLookupFragPositionWs;
 	
 	// get fragment pr0perties
-	float roughness = texture(gMetallicRoughnessAO, exTexcoord).g;
-	float metallic = texture(gMetallicRoughnessAO, exTexcoord).r;
-	vec4 fragPos = texture(gPosition, exTexcoord);
+	vec3 metallicRoughnessAO = gbufferMetallicRoughnessAO(exTexcoord);
+	float roughness = metallicRoughnessAO.g;
+	float metallic = metallicRoughnessAO.r;
+	vec4 fragPos = gbufferPosition(exTexcoord);
 	
 	//define max range for fragments to be regarded as reflective
 	bool range = (length(fragPos.xyz - viewPos) <= 50);
@@ -49,7 +48,7 @@ void main() {
 	//discard fragments of background, those that aren't fully metallic (this is implemented to limit SSR on the water surface) / out of range 
 	if (fragPos.x != 0 && fragPos.y != 0 && fragPos.z != 0 && metallic == 1.0 && range){
 		
-		vec3 fragN = normalize(texture(gNormal, exTexcoord).rgb);
+		vec3 fragN = gbufferNormal(exTexcoord);
 		
 		// calculate view direction
 		vec3 viewRay = (fragPos.xyz - viewPos.xyz);
@@ -111,7 +110,7 @@ void main() {
 			texPos.xy = lookupFrag / texSize;
 
 			// get position data for respective fragment
-			lookupFragPositionWs = texture(gPosition, texPos.xy);
+			lookupFragPositionWs = gbufferPosition(screenToTexcoord(texPos.xy));
 			lookupFragPositionView = ViewMatrix * lookupFragPositionWs;
 	
 			// get ratio of ray length that has been travelled 
@@ -155,7 +154,7 @@ void main() {
 			
 			lookupFrag = mix(reflectionRayStart.xy, reflectionRayEnd.xy, nextSearchStep);
 			texPos.xy = lookupFrag / texSize;
-			lookupFragPositionWs = texture(gPosition, texPos.xy);
+			lookupFragPositionWs = gbufferPosition(screenToTexcoord(texPos.xy));
 			lookupFragPositionView = ViewMatrix * lookupFragPositionWs;
 
 			viewDistance = -(reflectionRayStartView.z * reflectionRayEndView.z) / mix(reflectionRayEndView.z, reflectionRayStartView.z, nextSearchStep);
@@ -184,7 +183,7 @@ void main() {
 		float screenEdgefactor = clamp(1.0 - (smoothCoords.x + smoothCoords.y), 0.0, 1.0);
 		
 		// calculate cos of angle between rflection and normal of hit geometry
-		float angle = dot(reflectionRay, texture(gNormal,texPos.xy).rgb);
+		float angle = dot(reflectionRay, gbufferNormal(screenToTexcoord(texPos.xy)));
 
 		visibility =((secondPassHit == 1) ? 1 : 0)		// check if any geometry has been hit
 					* finalLookupFragPositionWs.w							// discard background reflections
@@ -202,7 +201,7 @@ void main() {
 		visibility = clamp(visibility, 0, 1);
 	}
 
-	vec4 reflectionColor = texture(gShaded, finalLookupPos.xy);
+	vec4 reflectionColor = texture(gShaded, screenToTexcoord(finalLookupPos.xy));
 
 	// save visibility in alpha channel for blending in different shader
 	fragColor = vec4(reflectionColor.rgb * visibility, visibility);
@@ -0,0 +1,73 @@
+#version 420 core
+
+// one step down the bloom mip chain, 13 bilinear taps covering a 6x6 texel footprint of the next larger level
+layout (location = 0) out vec3 outBloom;
+
+#include "../general/viewport.glsl"
+#include "../general/brightpass.glsl"
+
+layout (binding = 0) uniform sampler2D source;
+
+// texel size of the level being written, its texture coordinates match those of every other level
+uniform vec2 texelSize;
+// the first step reads the bright part the lighting passes wrote and suppresses single bright pixels, it only
+// thresholds itself when it reads the shaded image instead
+uniform bool firstLevel;
+uniform bool threshold;
+
+vec3 fetch(vec2 texcoord, vec2 offset, vec2 sourceTexelSize)
+{
+    return texture(source, clampToViewport(texcoord + offset * sourceTexelSize, sourceTexelSize)).rgb;
+}
+
+// weight of a tap group that keeps fireflies from flickering through the whole chain
+float karisWeight(vec3 color)
+{
+    return 1.0 / (1.0 + dot(color, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+void main()
+{
+    vec2 texcoord = gl_FragCoord.xy * texelSize;
+    vec2 sourceTexelSize = 1.0 / vec2(textureSize(source, 0));
+
+    vec3 a = fetch(texcoord, vec2(-2.0, 2.0), sourceTexelSize);
+    vec3 b = fetch(texcoord, vec2(0.0, 2.0), sourceTexelSize);
+    vec3 c = fetch(texcoord, vec2(2.0, 2.0), sourceTexelSize);
+    vec3 d = fetch(texcoord, vec2(-2.0, 0.0), sourceTexelSize);
+    vec3 e = fetch(texcoord, vec2(0.0, 0.0), sourceTexelSize);
+    vec3 f = fetch(texcoord, vec2(2.0, 0.0), sourceTexelSize);
+    vec3 g = fetch(texcoord, vec2(-2.0, -2.0), sourceTexelSize);
+    vec3 h = fetch(texcoord, vec2(0.0, -2.0), sourceTexelSize);
+    vec3 i = fetch(texcoord, vec2(2.0, -2.0), sourceTexelSize);
+    vec3 j = fetch(texcoord, vec2(-1.0, 1.0), sourceTexelSize);
+    vec3 k = fetch(texcoord, vec2(1.0, 1.0), sourceTexelSize);
+    vec3 l = fetch(texcoord, vec2(-1.0, -1.0), sourceTexelSize);
+    vec3 m = fetch(texcoord, vec2(1.0, -1.0), sourceTexelSize);
+
+    // the inner box weighs half, the four overlapping outer boxes an eighth each
+    vec3 groups[5] = vec3[](
+        (j + k + l + m) * 0.25,
+        (a + b + d + e) * 0.25,
+        (b + c + e + f) * 0.25,
+        (d + e + g + h) * 0.25,
+        (e + f + h + i) * 0.25
+    );
+    float weights[5] = float[](0.5, 0.125, 0.125, 0.125, 0.125);
+
+    vec3 color = vec3(0.0);
+    float weightSum = 0.0;
+    for (int n = 0; n < 5; n++)
+    {
+        float weight = weights[n];
+        if (firstLevel)
+        {
+            if (threshold) groups[n] = brightPart(groups[n]);
+            weight *= karisWeight(groups[n]);
+        }
+        color += groups[n] * weight;
+        weightSum += weight;
+    }
+
+    outBloom = color / weightSum;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#version 420 core
+
+// one step up the bloom mip chain, a 3x3 tent over the smaller level is added onto the next larger one
+layout (location = 0) out vec3 outBloom;
+
+#include "../general/viewport.glsl"
+
+layout (binding = 0) uniform sampler2D source;
+
+// texel size of the level being written
+uniform vec2 texelSize;
+// spread of the tent in texels of the smaller level
+uniform float radius;
+
+vec3 fetch(vec2 texcoord, vec2 offset, vec2 sourceTexelSize)
+{
+    return texture(source, clampToViewport(texcoord + offset * radius * sourceTexelSize, sourceTexelSize)).rgb;
+}
+
+void main()
+{
+    vec2 texcoord = gl_FragCoord.xy * texelSize;
+    vec2 sourceTexelSize = 1.0 / vec2(textureSize(source, 0));
+
+    vec3 color = fetch(texcoord, vec2(0.0, 0.0), sourceTexelSize) * 4.0;
+    color += (fetch(texcoord, vec2(-1.0, 0.0), sourceTexelSize) + fetch(texcoord, vec2(1.0, 0.0), sourceTexelSize)
+            + fetch(texcoord, vec2(0.0, -1.0), sourceTexelSize) + fetch(texcoord, vec2(0.0, 1.0), sourceTexelSize)) * 2.0;
+    color += fetch(texcoord, vec2(-1.0, -1.0), sourceTexelSize) + fetch(texcoord, vec2(1.0, -1.0), sourceTexelSize)
+           + fetch(texcoord, vec2(-1.0, 1.0), sourceTexelSize) + fetch(texcoord, vec2(1.0, 1.0), sourceTexelSize);
+
+    // blended additively onto the level, which keeps its own downsampled content
+    outBloom = color / 16.0;
+}
\ No newline at end of file
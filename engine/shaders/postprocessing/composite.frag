@@ -0,0 +1,52 @@
+#version 430 core
+
+out vec4 FragmentColor;
+
+in vec2 exTexcoord;
+
+// The only full screen pass from the linear HDR image to the display. It is compiled for every combination of the
+// enabled effects, which are applied in this order:
+// REFLECTIONS  blends the screen space reflections over the shaded image
+// DOF          blends the depth of field blur over the sharp image
+// BLOOM        adds the upsampled bloom chain
+// then the result is tone mapped.
+
+#include "../general/gbuffer.glsl"
+#include "../general/tonemap.glsl"
+uniform sampler2D gShaded;
+
+#ifdef REFLECTIONS
+#include "reflections.glsl"
+#endif
+
+#ifdef DOF
+#include "dof.glsl"
+uniform sampler2D gDof; // quarter resolution blur of DepthOfField and its foreground coverage
+#endif
+
+#ifdef BLOOM
+uniform sampler2D gBloom; // the largest level of the bloom chain, filtered up bilinearly
+uniform float bloomExposure;
+#endif
+
+void main()
+{
+	vec3 color = texture(gShaded, exTexcoord).rgb;
+
+#ifdef REFLECTIONS
+	color = blendReflections(color, exTexcoord);
+#endif
+
+#ifdef DOF
+	// the blur replaces the sharp image where the pixel itself or blurred foreground in front of it is out of focus
+	float coc = abs(circleOfConfusion(texture(gDepth, exTexcoord).r));
+	vec4 blurred = texture(gDof, clampToViewport(exTexcoord, 1.0 / vec2(textureSize(gDof, 0))));
+	color = mix(color, blurred.rgb, max(smoothstep(0.5, 1.5, coc), blurred.a));
+#endif
+
+#ifdef BLOOM
+	color += texture(gBloom, exTexcoord).rgb * bloomExposure;
+#endif
+
+	FragmentColor = vec4(tonemap(color), 1.0);
+}
\ No newline at end of file
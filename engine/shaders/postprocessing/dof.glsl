@@ -0,0 +1,18 @@
+// Circle of confusion of the depth of field passes, in half resolution pixels and signed: negative in front of the
+// focal plane, positive behind it, so comparing two values also tells which surface is closer.
+
+uniform float focalDepth;
+// m22 and m23 of the projection matrix, the view space depth is m23 / (ndc depth + m22)
+uniform vec2 depthLinearize;
+
+// view space depth difference to the blur radius, as a fraction of the viewport height
+const float COC_SCALE = 0.00009;
+// the largest blur is one DepthOfField tile of 16 pixels, so the dilation to the neighbouring tiles covers it
+const float MAX_COC = 8.0;
+
+float circleOfConfusion(float depth)
+{
+    // the background blurs as if it were 50 units away
+    float depthDiff = depth == 1.0 ? abs(50.0 - focalDepth) : depthLinearize.y / (depth * 2.0 - 1.0 + depthLinearize.x) + focalDepth;
+    return clamp(depthDiff * COC_SCALE * viewportSize.y * 0.5, -MAX_COC, MAX_COC);
+}
\ No newline at end of file
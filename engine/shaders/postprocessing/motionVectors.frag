@@ -0,0 +1,26 @@
+#version 420 core
+// movement of the pixel since the last frame in screen coordinates
+out vec2 Motion;
+
+in vec2 exTexcoord;
+
+#include "../general/viewport.glsl"
+uniform sampler2D depthTexture;
+
+uniform mat4 InverseViewProjectionMatrix;
+uniform mat4 PreviousViewProjectionMatrix; // without jitter
+uniform vec2 jitter;                       // of this frame's projection in normalized device coordinates
+
+// The scene does not move, so the motion of every pixel follows from its depth and the camera of both frames.
+// The background is reprojected as a point on the far plane.
+void main()
+{
+    vec2 screen = texcoordToScreen(exTexcoord);
+    vec4 ndc = vec4(screen, texture(depthTexture, exTexcoord).r, 1.0) * 2.0 - 1.0;
+    vec4 position = InverseViewProjectionMatrix * ndc;
+    position /= position.w;
+
+    vec4 previous = PreviousViewProjectionMatrix * position;
+    vec2 previousScreen = previous.xy / previous.w * 0.5 + 0.5;
+    Motion = screen - jitter * 0.5 - previousScreen;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+// Blends the screen space reflections over the shaded color, needs gbuffer.glsl. The visibility of the reflection is
+// in the alpha channel, rough surfaces take more of the blurred reflection.
+
+uniform sampler2D gReflection;
+uniform sampler2D gReflectionBlur;
+
+vec3 blendReflections(vec3 baseColor, vec2 texcoord)
+{
+    vec4 reflectionColor = texture(gReflection, texcoord);
+    vec3 reflectionBlurColor = texture(gReflectionBlur, texcoord).rgb;
+    float smoothness = clamp(1.0 - gbufferMetallicRoughnessAO(texcoord).g, 0.0, 1.0);
+
+    vec3 reflection = mix(reflectionBlurColor, reflectionColor.rgb, smoothness);
+    return mix(baseColor, reflection, reflectionColor.a);
+}
\ No newline at end of file
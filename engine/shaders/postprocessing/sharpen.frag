@@ -0,0 +1,34 @@
+#version 420 core
+out vec4 FragColor;
+
+uniform sampler2D source; // upscaled image the size of the window
+uniform vec2 outputSize;
+// 0 is the strongest sharpening, every unit halves it
+uniform float sharpness;
+
+// the strongest negative lobe the filter may use, keeps it from amplifying noise
+const float LOBE_LIMIT = 0.25 - 1.0 / 16.0;
+
+// Robust contrast adaptive sharpening after FSR 1 RCAS: a cross of the 4 neighbors is subtracted from the center
+// with the largest weight that keeps the result within the range the neighbors allow, so it does not clip or ring.
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 lastPixel = ivec2(outputSize) - 1;
+    vec3 north = texelFetch(source, min(pixel + ivec2(0, 1), lastPixel), 0).rgb;
+    vec3 west = texelFetch(source, max(pixel - ivec2(1, 0), ivec2(0)), 0).rgb;
+    vec3 center = texelFetch(source, pixel, 0).rgb;
+    vec3 east = texelFetch(source, min(pixel + ivec2(1, 0), lastPixel), 0).rgb;
+    vec3 south = texelFetch(source, max(pixel - ivec2(0, 1), ivec2(0)), 0).rgb;
+
+    vec3 neighborMin = min(min(north, west), min(east, south));
+    vec3 neighborMax = max(max(north, west), max(east, south));
+
+    // lobe weights at which the result would reach 0 or 1 in each channel
+    vec3 hitMin = neighborMin / max(4.0 * neighborMax, vec3(1e-5));
+    vec3 hitMax = (1.0 - neighborMax) / min(4.0 * neighborMin - 4.0, vec3(-1e-5));
+    vec3 channelLobe = max(-hitMin, hitMax);
+    float lobe = max(-LOBE_LIMIT, min(max(channelLobe.r, max(channelLobe.g, channelLobe.b)), 0.0)) * exp2(-sharpness);
+
+    FragColor = vec4((lobe * (north + west + east + south) + center) / (4.0 * lobe + 1.0), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#version 420 core
+out vec3 FragColor;
+
+in vec2 exTexcoord;
+
+#include "../general/gbuffer.glsl"
+uniform sampler2D gSsaoRaw;      // occlusion and linear depth of this frame
+uniform sampler2D gSsaoHistory;  // accumulated occlusion, linear depth and frame count of the previous frame
+
+uniform mat4 PreviousViewProjectionMatrix;
+uniform bool historyValid;
+
+// the history keeps the average of at most this many frames, older samples fade out
+const float MAX_FRAMES = 16.0;
+// relative depth difference up to which the reprojected history still shows the same surface
+const float DEPTH_TOLERANCE = 0.05;
+
+void main()
+{
+    // raw and history targets have the same size
+    vec2 current = texelFetch(gSsaoRaw, ivec2(gl_FragCoord.xy), 0).rg;
+    FragColor = vec3(current, 1.0);
+    if (!historyValid || current.y == 0.0) return;
+
+    // where the surface was on screen last frame, w of the clip position is its linear depth then
+    vec4 previous = PreviousViewProjectionMatrix * gbufferPosition(exTexcoord);
+    vec2 previousScreen = previous.xy / previous.w * 0.5 + 0.5;
+    if (any(lessThan(previousScreen, vec2(0.0))) || any(greaterThan(previousScreen, vec2(1.0)))) return;
+
+    vec2 texelSize = 1.0 / textureSize(gSsaoHistory, 0);
+    vec3 history = texture(gSsaoHistory, clampToViewport(screenToTexcoord(previousScreen), texelSize)).rgb;
+
+    // disoccluded, something else was visible there
+    if (abs(history.y - previous.w) > DEPTH_TOLERANCE * previous.w) return;
+
+    float frames = min(history.z + 1.0, MAX_FRAMES);
+    FragColor = vec3(mix(history.x, current.x, 1.0 / frames), current.y, frames);
+}
\ No newline at end of file
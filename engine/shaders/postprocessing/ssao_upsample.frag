@@ -0,0 +1,68 @@
+#version 420 core
+out float FragColor;
+
+in vec2 exTexcoord;
+
+#include "../general/gbuffer.glsl"
+uniform sampler2D gSsao; // reduced resolution occlusion and linear depth
+
+layout(shared) uniform SharedMatrices
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
+
+// how quickly taps lose weight with their relative depth difference and with the angle between the normals
+const float DEPTH_SHARPNESS = 20.0;
+const float NORMAL_SHARPNESS = 8.0;
+
+// bilinear upsampling where each of the four taps is weighted down when it lies on a different surface,
+// so occlusion does not bleed across depth and normal edges
+void main()
+{
+    vec4 position = gbufferPosition(exTexcoord);
+    if (position.w == 0.0)
+    {
+        FragColor = 1.0;
+        return;
+    }
+    float depth = -(ViewMatrix * position).z;
+    vec3 normal = gbufferNormal(exTexcoord);
+
+    vec2 lowSize = textureSize(gSsao, 0);
+    ivec2 lastTexel = ivec2(ceil(viewportScale * lowSize)) - 1;
+    vec2 lowPosition = exTexcoord * lowSize - 0.5;
+    ivec2 base = ivec2(floor(lowPosition));
+    vec2 fraction = lowPosition - floor(lowPosition);
+
+    float occlusion = 0.0;
+    float totalWeight = 0.0;
+    // falls back to the tap closest in depth if every tap is on another surface
+    float closestOcclusion = 1.0;
+    float closestDifference = 1e30;
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), lastTexel);
+        vec2 tap = texelFetch(gSsao, texel, 0).rg;
+        // background taps have no depth
+        if (tap.y == 0.0) continue;
+
+        vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+        float difference = abs(depth - tap.y) / depth;
+        vec3 tapNormal = gbufferNormal((vec2(texel) + 0.5) / lowSize);
+        float weight = bilinear.x * bilinear.y
+                     * exp(-DEPTH_SHARPNESS * difference)
+                     * pow(max(dot(normal, tapNormal), 0.0), NORMAL_SHARPNESS);
+
+        occlusion += tap.x * weight;
+        totalWeight += weight;
+        if (difference < closestDifference)
+        {
+            closestDifference = difference;
+            closestOcclusion = tap.x;
+        }
+    }
+
+    FragColor = totalWeight > 1e-4 ? occlusion / totalWeight : closestOcclusion;
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#version 420 core
+// texture coordinate of the hit, its visibility and the depth of the reflecting pixel for the resolve
+out vec4 FragColor;
+
+in vec2 exTexcoord;
+
+#include "../general/gbuffer.glsl"
+uniform sampler2D hiZ;  // closest depth per texel, every level halves the one before
+uniform int hiZLevels;
+
+uniform vec3 viewPos;
+uniform float maxRayDistance;
+uniform int maxIterations;
+uniform float tolerance;
+
+layout(shared) uniform SharedMatrices
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
+
+// screen coordinates and depth buffer depth of a view space position
+vec3 project(vec3 position)
+{
+    vec4 clip = ProjectionMatrix * vec4(position, 1.0);
+    return clip.xyz / clip.w * 0.5 + 0.5;
+}
+
+// view space distance of a depth buffer depth
+float linearDepth(float depth)
+{
+    return ProjectionMatrix[3][2] / (depth * 2.0 - 1.0 + ProjectionMatrix[2][2]);
+}
+
+// ray parameter at which the ray leaves a cell of the given size in viewport pixels
+float cellExit(vec3 start, vec3 delta, vec2 cell, float cellSize)
+{
+    vec2 boundary = (cell + step(0.0, delta.xy)) * cellSize / viewportSize;
+    vec2 safeDelta = mix(delta.xy, vec2(1e-8), lessThan(abs(delta.xy), vec2(1e-8)));
+    vec2 exit = (boundary - start.xy) / safeDelta;
+    return min(exit.x, exit.y);
+}
+
+// The ray is a straight line in screen coordinates and depth buffer depth. It advances cell by cell through the
+// hierarchical depth buffer: while it stays in front of the closest depth of a cell it skips the whole cell and moves to
+// the next coarser level, when it would reach that depth inside the cell it steps to the depth and refines to the finer
+// level, so empty space is crossed in a logarithmic number of steps. A hit is only accepted in the finest level.
+void main()
+{
+    FragColor = vec4(0.0);
+
+    vec3 metallicRoughnessAO = gbufferMetallicRoughnessAO(exTexcoord);
+    float metallic = metallicRoughnessAO.r;
+    vec4 fragPos = gbufferPosition(exTexcoord);
+
+    // background, not fully metallic (limits reflections to the water surface) or out of range fragments do not reflect
+    if (fragPos.w == 0.0 || metallic != 1.0 || length(fragPos.xyz - viewPos) > 50.0) return;
+    FragColor.w = texture(gDepth, exTexcoord).r;
+
+    vec3 viewDir = normalize(fragPos.xyz - viewPos);
+    vec3 reflectionRay = normalize(reflect(viewDir, gbufferNormal(exTexcoord)));
+
+    vec3 startView = (ViewMatrix * vec4(fragPos.xyz + reflectionRay * 0.1, 1.0)).xyz;
+    vec3 directionView = mat3(ViewMatrix) * reflectionRay;
+
+    // rays towards the camera end before the near plane
+    float rayLength = maxRayDistance;
+    float near = linearDepth(0.0);
+    if (directionView.z > 0.0) rayLength = min(rayLength, (-near * 1.01 - startView.z) / directionView.z);
+    if (rayLength <= 0.0) return;
+
+    vec3 start = project(startView);
+    vec3 delta = project(startView + directionView * rayLength) - start;
+
+    // the ray ends where it leaves the screen
+    float endT = 1.0;
+    if (delta.x > 0.0) endT = min(endT, (1.0 - start.x) / delta.x);
+    if (delta.x < 0.0) endT = min(endT, -start.x / delta.x);
+    if (delta.y > 0.0) endT = min(endT, (1.0 - start.y) / delta.y);
+    if (delta.y < 0.0) endT = min(endT, -start.y / delta.y);
+
+    // steps past cell boundaries by a thousandth of a pixel
+    float epsilon = 0.001 / max(length(delta.xy * viewportSize), 1e-4);
+
+    // begins behind the pixel of the ray start
+    int level = 0;
+    float t = cellExit(start, delta, floor(start.xy * viewportSize), 1.0) + epsilon;
+    bool hit = false;
+    float depthDiff = 0.0;
+
+    for (int i = 0; i < maxIterations && t < endT; i++)
+    {
+        vec3 position = start + delta * t;
+        float cellSize = float(1 << level);
+        vec2 cell = floor(position.xy * viewportSize / cellSize);
+        float minDepth = texelFetch(hiZ, ivec2(cell), level).r;
+        float exitT = cellExit(start, delta, cell, cellSize);
+
+        if (position.z >= minDepth)
+        {
+            // behind the closest surface of the cell, only the finer level tells whether it is behind any surface
+            if (level > 0)
+            {
+                level--;
+                continue;
+            }
+
+            // hit when it is closely behind the surface, otherwise it passes behind the geometry
+            depthDiff = linearDepth(position.z) - linearDepth(minDepth);
+            if (depthDiff < tolerance)
+            {
+                hit = true;
+                break;
+            }
+            t = exitT + epsilon;
+            continue;
+        }
+
+        // a ray going into the screen may reach the closest depth before leaving the cell
+        float planeT = delta.z > 0.0 ? (minDepth - start.z) / delta.z : exitT;
+        if (planeT < exitT)
+        {
+            t = max(t, planeT);
+            if (level == 0)
+            {
+                hit = true;
+                break;
+            }
+            level--;
+        }
+        else
+        {
+            t = exitT + epsilon;
+            level = min(level + 1, hiZLevels - 1);
+        }
+    }
+
+    if (!hit) return;
+
+    vec2 hitScreen = (start + delta * t).xy;
+    vec2 hitTexcoord = screenToTexcoord(hitScreen);
+    vec4 hitPos = gbufferPosition(hitTexcoord);
+    vec3 hitView = (ViewMatrix * hitPos).xyz;
+
+    // smoothly discard fragments close to edge of image to hide discontinuities
+    vec2 smoothCoords = smoothstep(0.25, 0.55, abs(vec2(0.5) - hitScreen));
+    float screenEdgefactor = clamp(1.0 - (smoothCoords.x + smoothCoords.y), 0.0, 1.0);
+
+    // cos of angle between reflection and normal of hit geometry
+    float angle = dot(reflectionRay, gbufferNormal(hitTexcoord));
+
+    float visibility = hitPos.w                                                         // discard background reflections
+                     * (1.0 - max(angle >= 0.0 ? 1.0 : angle, 0.0))                     // discard ray that hit geometry from the inside
+                     * (1.0 - max(dot(-viewDir, reflectionRay), 0.0))                   // if we look at the geometry from behind
+                     * (1.0 - clamp(depthDiff / tolerance, 0.0, 1.0))                   // if we did not hit exactly
+                     * (1.0 - clamp(length(hitView - startView) / maxRayDistance, 0.0, 1.0)) // fade out with the travelled distance
+                     * screenEdgefactor                                                 // if we are close to the edge of the screen
+                     * metallic;                                                        // reflectivity of material
+
+    FragColor.xyz = vec3(hitTexcoord, clamp(visibility, 0.0, 1.0));
+}
\ No newline at end of file
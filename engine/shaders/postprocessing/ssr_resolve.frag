@@ -0,0 +1,40 @@
+#version 420 core
+out vec4 FragColor;
+
+in vec2 exTexcoord;
+
+#include "../general/gbuffer.glsl"
+uniform sampler2D gHits;   // hit texture coordinate, visibility and depth of the reflecting pixel, full or half resolution
+uniform sampler2D gShaded;
+
+// looks up the reflected color at full resolution, a half resolution trace takes the hit of the closest of the four
+// nearest traced pixels in depth, so reflections do not leak over the edges of the reflecting surface
+void main()
+{
+    vec2 hitsSize = textureSize(gHits, 0);
+    vec4 hit;
+    if (hitsSize == vec2(textureSize(gShaded, 0)))
+    {
+        hit = texelFetch(gHits, ivec2(gl_FragCoord.xy), 0);
+    }
+    else
+    {
+        float depth = texture(gDepth, exTexcoord).r;
+        ivec2 lastTexel = ivec2(ceil(viewportScale * hitsSize)) - 1;
+        ivec2 base = ivec2(floor(exTexcoord * hitsSize - 0.5));
+        float closestDifference = 1e30;
+        for (int i = 0; i < 4; i++)
+        {
+            vec4 tap = texelFetch(gHits, clamp(base + ivec2(i & 1, i >> 1), ivec2(0), lastTexel), 0);
+            float difference = abs(tap.w - depth);
+            if (difference < closestDifference)
+            {
+                closestDifference = difference;
+                hit = tap;
+            }
+        }
+    }
+
+    // save visibility in alpha channel for blending in different shader
+    FragColor = vec4(texture(gShaded, hit.xy).rgb * hit.z, hit.z);
+}
\ No newline at end of file
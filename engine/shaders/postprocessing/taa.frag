@@ -0,0 +1,58 @@
+#version 420 core
+out vec4 FragColor;
+
+in vec2 exTexcoord;
+
+#include "temporal.glsl"
+uniform sampler2D gCurrent;  // display referred image of this frame, rendered with a jittered projection
+uniform sampler2D gHistory;  // the result of the last frame
+uniform sampler2D gMotion;
+uniform sampler2D depthTexture;
+
+uniform bool historyValid;
+// weight of this frame, the history averages about the last 1 / feedback frames
+uniform float feedback;
+
+// Temporal anti-aliasing: every frame samples a different position inside each pixel, the reprojected history blends
+// them over frames. The history is clipped to the colors around the pixel this frame, so it cannot keep showing
+// disoccluded surfaces, and the motion is taken from the closest pixel nearby so edges move with the foreground.
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 lastPixel = ivec2(viewportSize) - 1;
+
+    vec3 current = texelFetch(gCurrent, pixel, 0).rgb;
+    vec3 boxMin = rgbToYCoCg(current);
+    vec3 boxMax = boxMin;
+    float closestDepth = 1.0;
+    ivec2 closestPixel = pixel;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            ivec2 neighbor = clamp(pixel + ivec2(x, y), ivec2(0), lastPixel);
+            vec3 color = rgbToYCoCg(texelFetch(gCurrent, neighbor, 0).rgb);
+            boxMin = min(boxMin, color);
+            boxMax = max(boxMax, color);
+
+            float depth = texelFetch(depthTexture, neighbor, 0).r;
+            if (depth < closestDepth)
+            {
+                closestDepth = depth;
+                closestPixel = neighbor;
+            }
+        }
+    }
+
+    FragColor = vec4(current, 1.0);
+    if (!historyValid) return;
+
+    vec2 historyTexcoord = reprojectTexcoord(exTexcoord, texelFetch(gMotion, closestPixel, 0).rg);
+    if (!insideViewport(historyTexcoord)) return;
+
+    vec2 texelSize = 1.0 / vec2(textureSize(gHistory, 0));
+    vec3 history = texture(gHistory, clampToViewport(historyTexcoord, texelSize)).rgb;
+    history = yCoCgToRgb(clipToBox(rgbToYCoCg(history), boxMin, boxMax));
+
+    FragColor.rgb = mix(history, current, feedback);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+// Reprojection and history rectification shared by the temporal passes. Motion vectors hold the movement of a pixel
+// since the last frame in screen coordinates, without the jitter of either frame.
+
+#include "../general/viewport.glsl"
+
+// texture coordinate of the same surface in the targets of the last frame
+vec2 reprojectTexcoord(vec2 texcoord, vec2 motion)
+{
+    return screenToTexcoord(texcoordToScreen(texcoord) - motion);
+}
+
+// whether a reprojected texture coordinate was inside the viewport of the last frame
+bool insideViewport(vec2 texcoord)
+{
+    vec2 screen = texcoordToScreen(texcoord);
+    return all(greaterThanEqual(screen, vec2(0.0))) && all(lessThanEqual(screen, vec2(1.0)));
+}
+
+// luma and chroma separate better than red, green and blue, the neighborhood box fits the colors tighter
+vec3 rgbToYCoCg(vec3 color)
+{
+    return vec3(0.25 * color.r + 0.5 * color.g + 0.25 * color.b,
+                0.5 * color.r - 0.5 * color.b,
+                -0.25 * color.r + 0.5 * color.g - 0.25 * color.b);
+}
+
+vec3 yCoCgToRgb(vec3 color)
+{
+    return vec3(color.x + color.y - color.z, color.x + color.z, color.x - color.y - color.z);
+}
+
+// History that lies outside the range of colors around the pixel this frame shows something that is no longer there.
+// It is moved along the line towards the center of the box until it touches the box, which keeps more of its hue than
+// clamping every channel separately.
+vec3 clipToBox(vec3 history, vec3 boxMin, vec3 boxMax)
+{
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extent = max(0.5 * (boxMax - boxMin), vec3(1e-4));
+    vec3 offset = history - center;
+    vec3 units = abs(offset / extent);
+    float maxUnit = max(units.x, max(units.y, units.z));
+    return maxUnit > 1.0 ? center + offset / maxUnit : history;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#version 420 core
+out vec4 FragColor;
+
+// texture coordinate in the rendered viewport of the source, the pass covers the whole window
+in vec2 exTexcoord;
+
+#include "../general/viewport.glsl"
+uniform sampler2D source; // display referred image of the rendered viewport
+
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+// Edge adaptive spatial upsampling after FSR 1 EASU. The 12 texels around the output pixel are weighted with an
+// approximated Lanczos lobe. The lobe is rotated to the local gradient, stretched along the edge and sharpened across
+// it the more the area looks like an edge, and the result is limited to the range of the 4 closest texels so the
+// negative parts of the lobe cannot ring.
+void main()
+{
+    vec2 position = exTexcoord * vec2(textureSize(source, 0)) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 fraction = position - floor(position);
+    ivec2 lastTexel = ivec2(viewportSize) - 1;
+
+    // 4x4 texels, the 2x2 around the pixel in the middle
+    vec3 color[16];
+    float lumas[16];
+    for (int i = 0; i < 16; i++)
+    {
+        ivec2 texel = clamp(base + ivec2(i % 4 - 1, i / 4 - 1), ivec2(0), lastTexel);
+        color[i] = texelFetch(source, texel, 0).rgb;
+        lumas[i] = luma(color[i]);
+    }
+
+    // gradient direction and edge strength at each of the middle texels, weighted bilinearly
+    vec2 direction = vec2(0.0);
+    float edge = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        int center = (offset.y + 1) * 4 + offset.x + 1;
+        vec2 weight = mix(1.0 - fraction, fraction, vec2(offset));
+        float bilinear = weight.x * weight.y;
+
+        float west = lumas[center - 1], east = lumas[center + 1], south = lumas[center - 4], north = lumas[center + 4];
+        float c = lumas[center];
+        vec2 gradient = vec2(east - west, north - south);
+        // one for a step between the neighbors, zero for a single texel line or a flat area
+        vec2 length2 = clamp(abs(gradient) / max(vec2(max(abs(east - c), abs(c - west)), max(abs(north - c), abs(c - south))), 1e-5), 0.0, 1.0);
+        length2 *= length2;
+
+        direction += gradient * bilinear;
+        edge += (length2.x + length2.y) * bilinear;
+    }
+    edge *= 0.5;
+    edge *= edge;
+
+    float directionLength = length(direction);
+    direction = directionLength < 1.0 / 32768.0 ? vec2(1.0, 0.0) : direction / directionLength;
+
+    // an axis aligned edge is stretched less than a diagonal one, whose texels lie further apart along it
+    float stretch = dot(direction, direction) / max(abs(direction.x), abs(direction.y));
+    vec2 scale = vec2(1.0 + (stretch - 1.0) * edge, 1.0 - 0.5 * edge);
+    // the lobe narrows from a wide window to a sharper one on edges
+    float lobe = 0.5 - 0.29 * edge;
+    float clip = 1.0 / lobe;
+
+    vec3 result = vec3(0.0);
+    float totalWeight = 0.0;
+    for (int i = 0; i < 16; i++)
+    {
+        // the corners of the 4x4 block are too far to contribute
+        if (i == 0 || i == 3 || i == 12 || i == 15) continue;
+        vec2 offset = vec2(i % 4 - 1, i / 4 - 1) - fraction;
+        vec2 rotated = vec2(dot(offset, direction), dot(offset, vec2(-direction.y, direction.x))) * scale;
+        float distance2 = min(dot(rotated, rotated), clip);
+
+        // polynomial approximation of a windowed Lanczos 2 lobe over the squared distance
+        float window = 0.4 * distance2 - 1.0;
+        float base2 = lobe * distance2 - 1.0;
+        window = 25.0 / 16.0 * window * window - (25.0 / 16.0 - 1.0);
+        float weight = window * base2 * base2;
+
+        result += color[i] * weight;
+        totalWeight += weight;
+    }
+    result /= totalWeight;
+
+    vec3 nearestMin = min(min(color[5], color[6]), min(color[9], color[10]));
+    vec3 nearestMax = max(max(color[5], color[6]), max(color[9], color[10]));
+    FragColor = vec4(clamp(result, nearestMin, nearestMax), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec3 inPosition;
+
+out vec2 exTexcoord;
+
+// the lookup table covers its whole target, unlike the screen quad it ignores the screen viewport
+void main()
+{
+    exTexcoord = inPosition.xy * 0.5 + 0.5;
+    gl_Position = vec4(inPosition, 1.0);
+}
\ No newline at end of file
@@ -16,7 +16,9 @@ namespace engine
 
 	GLuint Camera::getUboBP() const { return uboBP; }
 
-	Matrix4 Camera::getProjectionMatrix() const { return projectionMatrix; }
+	// the jitter translates clip space, which moves every projected point by the same offset in normalized device coordinates
+	Matrix4 Camera::getProjectionMatrix() const { return Matrix4::CreateTranslation(jitter.x, jitter.y, 0.f) * projectionMatrix; }
+	Matrix4 Camera::getUnjitteredProjectionMatrix() const { return projectionMatrix; }
 	void Camera::setOrtho(float l, float r, float b, float t, float n, float f)
 	{
 		projectionMatrix = Matrix4::CreateOrthographicProjection(l, r, b, t, n, f);
@@ -38,6 +40,33 @@ namespace engine
 		position = eye;
 	}
 
+	Matrix4 Camera::getPreviousViewMatrix() const { return previousViewMatrix; }
+	Matrix4 Camera::getPreviousProjectionMatrix() const { return previousProjectionMatrix; }
+
+	// radical inverse of the index in the base, low discrepancy in [0, 1)
+	static float halton(unsigned int index, unsigned int base)
+	{
+		float result = 0.f;
+		float fraction = 1.f / base;
+		while (index > 0)
+		{
+			result += (index % base) * fraction;
+			index /= base;
+			fraction /= base;
+		}
+		return result;
+	}
+
+	void Camera::setJitter(unsigned int frame, unsigned int viewportWidth, unsigned int viewportHeight)
+	{
+		// the sequence starts at 1, index 0 would be the corner of the pixel in both dimensions
+		unsigned int index = frame % JITTER_PHASES + 1;
+		Vector2 pixelOffset(halton(index, 2) - 0.5f, halton(index, 3) - 0.5f);
+		jitter = Vector2(pixelOffset.x * 2.f / viewportWidth, pixelOffset.y * 2.f / viewportHeight);
+	}
+	void Camera::clearJitter() { jitter = Vector2(0.f, 0.f); }
+	Vector2 Camera::getJitter() const { return jitter; }
+
 	float Camera::getPitch() { return pitch; }
 	float Camera::getYaw() { return yaw; }
 	Vector3 Camera::getPosition() { return position; }
@@ -46,6 +75,9 @@ namespace engine
 	{
 		Engine& engine = Engine::getInstance();
 
+		previousViewMatrix = viewMatrix;
+		previousProjectionMatrix = projectionMatrix;
+
 		// handle mouse
 		pitch += -cursorDiff.y * CAMERA_MOUSE_SENSITIVITY;
 		yaw += cursorDiff.x * CAMERA_MOUSE_SENSITIVITY;
@@ -101,7 +133,8 @@ namespace engine
 		glBindBuffer(GL_UNIFORM_BUFFER, uboId);
 		{
 			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Matrix4), &viewMatrix);
-			glBufferSubData(GL_UNIFORM_BUFFER, sizeof(Matrix4), sizeof(Matrix4), &projectionMatrix);
+			Matrix4 jitteredProjection = getProjectionMatrix();
+			glBufferSubData(GL_UNIFORM_BUFFER, sizeof(Matrix4), sizeof(Matrix4), &jitteredProjection);
 		}
 	}
 }
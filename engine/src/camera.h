@@ -10,6 +10,8 @@ namespace engine
 
 	const float MAX_TILT = 0.95f * HALF_PI;
 
+	const unsigned int JITTER_PHASES = 8;
+
 	class Camera
 	{
 	public:
@@ -18,8 +20,9 @@ namespace engine
 
 		GLuint getUboBP() const;
 
-		// projection matrix
+		// projection matrix, including the jitter
 		Matrix4 getProjectionMatrix() const;
+		Matrix4 getUnjitteredProjectionMatrix() const;
 		void setOrtho(float l, float r, float b, float t, float n, float f);
 		void setPerspective(float fov, float aspect, float n, float f);
 
@@ -27,6 +30,17 @@ namespace engine
 		Matrix4 getViewMatrix() const;
 		void lookAt(Vector3 eye, Vector3 center);
 
+		// matrices of the frame before the last update, without jitter, to reproject into the last frame
+		Matrix4 getPreviousViewMatrix() const;
+		Matrix4 getPreviousProjectionMatrix() const;
+
+		// shifts the projection by a sub-pixel offset that follows a Halton sequence over JITTER_PHASES frames, so
+		// temporal anti-aliasing gathers a different sample position every frame, the viewport size is in pixels
+		void setJitter(unsigned int frame, unsigned int viewportWidth, unsigned int viewportHeight);
+		void clearJitter();
+		// offset of the projection in normalized device coordinates
+		Vector2 getJitter() const;
+
 		// camera properties
 		float getPitch();
 		float getYaw();
@@ -40,6 +54,9 @@ namespace engine
 
 		Matrix4 projectionMatrix;
 		Matrix4 viewMatrix;
+		Matrix4 previousProjectionMatrix;
+		Matrix4 previousViewMatrix;
+		Vector2 jitter = Vector2(0.f, 0.f);
 
 		float pitch = 0.f;
 		float yaw = 0.f;
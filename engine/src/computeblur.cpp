@@ -0,0 +1,117 @@
+#include "computeblur.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "exceptions.h"
+
+namespace engine
+{
+	// texture units of the source and of the depth of the bilateral filter
+	const int SOURCE_UNIT = 0;
+	const int DEPTH_UNIT = 1;
+
+	ComputeBlur::ComputeBlur(const ScreenViewport* viewport) : viewport(viewport)
+	{
+	}
+
+	ComputeBlur::~ComputeBlur()
+	{
+		for (auto& program : programs)
+		{
+			delete program.second;
+		}
+	}
+
+	ShaderProgram* ComputeBlur::getProgram(GLenum format)
+	{
+		auto found = programs.find(format);
+		if (found != programs.end()) return found->second;
+
+		std::string qualifier;
+		switch (format)
+		{
+		case GL_R8: qualifier = "r8"; break;
+		case GL_RGBA8: qualifier = "rgba8"; break;
+		case GL_RG16F: qualifier = "rg16f"; break;
+		case GL_RGBA16F: qualifier = "rgba16f"; break;
+		default: throw Exception("Unsupported format of a compute blur target.");
+		}
+
+		ShaderProgram* program = new ShaderProgram();
+		try
+		{
+			program->initCompute("shaders/postprocessing/blur.comp", {
+				"GROUP_SIZE " + std::to_string(GROUP_SIZE),
+				"MAX_APRON " + std::to_string(MAX_APRON),
+				"IMAGE_FORMAT " + qualifier
+			});
+			program->link();
+		}
+		catch (...)
+		{
+			delete program;
+			throw;
+		}
+		program->use();
+		program->setUniform("source", SOURCE_UNIT);
+		program->setUniform("depth", DEPTH_UNIT);
+		program->unuse();
+
+		programs[format] = program;
+		return program;
+	}
+
+	void ComputeBlur::box(GLuint source, GLuint intermediate, GLuint destination, GLenum format, int radius, int separation)
+	{
+		blur(source, intermediate, destination, format, radius, separation, 0.0f, false);
+	}
+
+	void ComputeBlur::gaussian(GLuint source, GLuint intermediate, GLuint destination, GLenum format, float sigma)
+	{
+		blur(source, intermediate, destination, format, (int)std::ceil(3.0f * sigma), 1, sigma, false);
+	}
+
+	void ComputeBlur::bilateral(GLuint source, GLuint intermediate, GLuint destination, GLenum format, float sigma, GLuint depthTexture, const Matrix4& projectionMatrix)
+	{
+		glActiveTexture(GL_TEXTURE0 + DEPTH_UNIT);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+		ShaderProgram* program = getProgram(format);
+		program->use();
+		// m22 and m23 of a perspective projection
+		program->setUniform("depthLinearize", Vector2(projectionMatrix.data[10], projectionMatrix.data[14]));
+		blur(source, intermediate, destination, format, (int)std::ceil(3.0f * sigma), 1, sigma, true);
+	}
+
+	void ComputeBlur::blur(GLuint source, GLuint intermediate, GLuint destination, GLenum format, int radius, int separation, float sigma, bool useDepth)
+	{
+		separation = std::max(separation, 1);
+		radius = std::max(std::min(radius, MAX_APRON / separation), 0);
+
+		ShaderProgram* program = getProgram(format);
+		program->use();
+		program->setUniform("radius", radius);
+		program->setUniform("separation", separation);
+		program->setUniform("sigma", sigma);
+		program->setUniform("useDepth", useDepth ? 1 : 0);
+
+		dispatch(source, intermediate, format, true);
+		dispatch(intermediate, destination, format, false);
+		program->unuse();
+	}
+
+	void ComputeBlur::dispatch(GLuint source, GLuint destination, GLenum format, bool horizontal)
+	{
+		glActiveTexture(GL_TEXTURE0 + SOURCE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, source);
+		glBindImageTexture(0, destination, 0, GL_FALSE, 0, GL_WRITE_ONLY, format);
+
+		unsigned int lineLength = horizontal ? viewport->getWidth() : viewport->getHeight();
+		unsigned int lineCount = horizontal ? viewport->getHeight() : viewport->getWidth();
+		programs[format]->setUniform("horizontal", horizontal ? 1 : 0);
+		glDispatchCompute((lineLength + GROUP_SIZE - 1) / GROUP_SIZE, lineCount, 1);
+		// the vertical pass samples what the horizontal one wrote, the passes after the blur sample the result
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "matrix.h"
+#include "screenviewport.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Separable blurs of the screen targets in compute shaders. Every group copies a row or column segment and the taps
+	// reaching past its ends into shared memory once, so a pass fetches about one texel per pixel whatever the radius,
+	// where a fragment shader fetches every tap from the texture. The horizontal pass writes an intermediate target of
+	// the same size and format that the vertical pass reads. Sources are sampled with texelFetch and may have any format,
+	// the intermediate and the destination are written as images and need immutable storage like the render graph pool.
+	class ComputeBlur
+	{
+	public:
+		static const unsigned int GROUP_SIZE = 64;
+		// the furthest tap from the center in pixels, radius times separation
+		static const int MAX_APRON = 32;
+
+		ComputeBlur(const ScreenViewport* viewport);
+		~ComputeBlur();
+
+		// equally weighted taps every separation pixels, radius taps to each side
+		void box(GLuint source, GLuint intermediate, GLuint destination, GLenum format, int radius, int separation = 1);
+		// gaussian weights with the standard deviation in pixels, cut off after three deviations
+		void gaussian(GLuint source, GLuint intermediate, GLuint destination, GLenum format, float sigma);
+		// gaussian weights that fall off with the depth difference to the center, so edges stay sharp,
+		// the source is read at the pixels of a depth texture the size of the targets
+		void bilateral(GLuint source, GLuint intermediate, GLuint destination, GLenum format, float sigma, GLuint depthTexture, const Matrix4& projectionMatrix);
+	private:
+		void blur(GLuint source, GLuint intermediate, GLuint destination, GLenum format, int radius, int separation, float sigma, bool useDepth);
+		void dispatch(GLuint source, GLuint destination, GLenum format, bool horizontal);
+		// the image format decides the layout qualifier, one program per format compiled on first use
+		ShaderProgram* getProgram(GLenum format);
+
+		const ScreenViewport* viewport;
+		std::map<GLenum, ShaderProgram*> programs;
+	};
+}
\ No newline at end of file
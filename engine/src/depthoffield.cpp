@@ -0,0 +1,113 @@
+#include "depthoffield.h"
+
+#include <string>
+#include <vector>
+
+namespace engine
+{
+	// texture units of the color inputs, the GBuffer uses the units up to GB_DEPTH_UNIT
+	const int COLOR_UNIT = GBuffer::GB_DEPTH_UNIT + 1;
+	const int REFLECTION_UNIT = GBuffer::GB_DEPTH_UNIT + 2;
+	const int REFLECTION_BLUR_UNIT = GBuffer::GB_DEPTH_UNIT + 3;
+
+	DepthOfField::DepthOfField(const GBuffer* gbuffer, const ScreenViewport* viewport) : gbuffer(gbuffer), viewport(viewport)
+	{
+		std::vector<std::string> defines = { "GROUP_SIZE " + std::to_string(GROUP_SIZE) };
+
+		std::vector<std::string> prefilterDefines = defines;
+		std::vector<std::string> gbufferDefines = gbuffer->getShaderDefines();
+		prefilterDefines.insert(prefilterDefines.end(), gbufferDefines.begin(), gbufferDefines.end());
+
+		prefilterProgram = new ShaderProgram();
+		prefilterProgram->initCompute("shaders/postprocessing/dofPrefilter.comp", prefilterDefines);
+		prefilterProgram->link();
+		gbuffer->updateShader(prefilterProgram);
+		prefilterProgram->use();
+		prefilterProgram->setUniform("gColor", COLOR_UNIT);
+		prefilterProgram->setUniform("gReflection", REFLECTION_UNIT);
+		prefilterProgram->setUniform("gReflectionBlur", REFLECTION_BLUR_UNIT);
+		prefilterProgram->unuse();
+
+		tileProgram = new ShaderProgram();
+		tileProgram->initCompute("shaders/postprocessing/dofTiles.comp", defines);
+		tileProgram->link();
+
+		dilateProgram = new ShaderProgram();
+		dilateProgram->initCompute("shaders/postprocessing/dofDilate.comp", defines);
+		dilateProgram->link();
+
+		gatherProgram = new ShaderProgram();
+		gatherProgram->initCompute("shaders/postprocessing/dofGather.comp", defines);
+		gatherProgram->link();
+		gatherProgram->use();
+		gatherProgram->setUniform("prefiltered", COLOR_UNIT);
+		gatherProgram->unuse();
+	}
+
+	DepthOfField::~DepthOfField()
+	{
+		delete prefilterProgram;
+		delete tileProgram;
+		delete dilateProgram;
+		delete gatherProgram;
+	}
+
+	void DepthOfField::dispatch(unsigned int width, unsigned int height)
+	{
+		glDispatchCompute((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+		// the next dispatch loads the images or samples them
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+
+	void DepthOfField::prefilter(GLuint colorTexture, GLuint reflectionTexture, GLuint reflectionBlurTexture, GLuint prefilterTexture, const Matrix4& projectionMatrix)
+	{
+		gbuffer->bindTextures();
+		glActiveTexture(GL_TEXTURE0 + COLOR_UNIT);
+		glBindTexture(GL_TEXTURE_2D, colorTexture);
+		glActiveTexture(GL_TEXTURE0 + REFLECTION_UNIT);
+		glBindTexture(GL_TEXTURE_2D, reflectionTexture);
+		glActiveTexture(GL_TEXTURE0 + REFLECTION_BLUR_UNIT);
+		glBindTexture(GL_TEXTURE_2D, reflectionBlurTexture);
+		glBindImageTexture(0, prefilterTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+		prefilterProgram->use();
+		prefilterProgram->setUniform("useReflections", reflectionTexture != 0);
+		// m22 and m23 of a perspective projection
+		prefilterProgram->setUniform("depthLinearize", Vector2(projectionMatrix.data[10], projectionMatrix.data[14]));
+		prefilterProgram->setUniform("focalDepth", focalDepth);
+		dispatch((viewport->getWidth() + 1) / 2, (viewport->getHeight() + 1) / 2);
+		prefilterProgram->unuse();
+	}
+
+	void DepthOfField::buildTiles(GLuint prefilterTexture, GLuint tileTexture, GLuint dilatedTexture)
+	{
+		unsigned int tilesX = (viewport->getWidth() + TILE_SIZE - 1) / TILE_SIZE;
+		unsigned int tilesY = (viewport->getHeight() + TILE_SIZE - 1) / TILE_SIZE;
+
+		// one group reduces the half resolution pixels of a tile
+		glBindImageTexture(0, prefilterTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+		glBindImageTexture(1, tileTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16F);
+		tileProgram->use();
+		glDispatchCompute(tilesX, tilesY, 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		tileProgram->unuse();
+
+		glBindImageTexture(0, tileTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R16F);
+		glBindImageTexture(1, dilatedTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16F);
+		dilateProgram->use();
+		dispatch(tilesX, tilesY);
+		dilateProgram->unuse();
+	}
+
+	void DepthOfField::gather(GLuint prefilterTexture, GLuint dilatedTexture, GLuint gatherTexture)
+	{
+		glActiveTexture(GL_TEXTURE0 + COLOR_UNIT);
+		glBindTexture(GL_TEXTURE_2D, prefilterTexture);
+		glBindImageTexture(0, dilatedTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R16F);
+		glBindImageTexture(1, gatherTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+		gatherProgram->use();
+		dispatch((viewport->getWidth() + 3) / 4, (viewport->getHeight() + 3) / 4);
+		gatherProgram->unuse();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "geometrybuffer.h"
+#include "screenviewport.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Depth of field in compute shaders with a cost that does not grow with the blur. The circle of confusion is
+	// computed once into a half resolution copy of the image, its largest value per tile is dilated over the neighbouring
+	// tiles, and a fixed kernel scaled to the dilated tile gathers the blur at quarter resolution, taking from each tap
+	// only as much as its own circle of confusion reaches the pixel. The composite blends it over the sharp image.
+	class DepthOfField
+	{
+	public:
+		static const unsigned int GROUP_SIZE = 8;
+		// full resolution pixels per side of a tile, a group of the half resolution image
+		static const unsigned int TILE_SIZE = 2 * GROUP_SIZE;
+
+		// the prefilter reads the roughness of the current layout of gbuffer, create a new instance when it changes
+		DepthOfField(const GBuffer* gbuffer, const ScreenViewport* viewport);
+		~DepthOfField();
+
+		// average color and signed circle of confusion into a GL_RGBA16F texture of half the target size, the reflections
+		// are blended over the color like the composite does unless their textures are 0
+		void prefilter(GLuint colorTexture, GLuint reflectionTexture, GLuint reflectionBlurTexture, GLuint prefilterTexture, const Matrix4& projectionMatrix);
+		// largest circle of confusion per tile, then of each tile and its neighbours, GL_R16F textures of the tile count
+		void buildTiles(GLuint prefilterTexture, GLuint tileTexture, GLuint dilatedTexture);
+		// blurred color and the coverage by blurred foreground into a GL_RGBA16F texture of a quarter the target size
+		void gather(GLuint prefilterTexture, GLuint dilatedTexture, GLuint gatherTexture);
+
+		// the plane in focus lies at a view space z of +focalDepth, a negative focalDepth puts it in front of the camera
+		float focalDepth = 2.0f;
+	private:
+		void dispatch(unsigned int width, unsigned int height);
+
+		const GBuffer* gbuffer;
+		const ScreenViewport* viewport;
+
+		ShaderProgram* prefilterProgram = nullptr;
+		ShaderProgram* tileProgram = nullptr;
+		ShaderProgram* dilateProgram = nullptr;
+		ShaderProgram* gatherProgram = nullptr;
+	};
+}
\ No newline at end of file
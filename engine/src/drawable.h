@@ -1,11 +1,17 @@
 #pragma once
 
+#include <vector>
+
 #include "shader.h"
 
 namespace engine
 {
+	class Mesh;
+
 	class IDrawable {
 	public:
 		virtual void draw(ShaderProgram* program) const = 0;
+		// for passes that draw the meshes themselves, like the visibility buffer
+		virtual std::vector<Mesh*> getMeshes() { return {}; }
 	};
 }
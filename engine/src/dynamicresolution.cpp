@@ -0,0 +1,87 @@
+#include "dynamicresolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine
+{
+	const float DynamicResolution::SCALE_STEP = 0.05f;
+	// weight of a new measurement in the smoothed time
+	const double SMOOTHING = 0.2;
+
+	DynamicResolution::DynamicResolution()
+	{
+		glGenQueries(FRAMES_IN_FLIGHT, startQueries);
+		glGenQueries(FRAMES_IN_FLIGHT, endQueries);
+	}
+
+	DynamicResolution::~DynamicResolution()
+	{
+		glDeleteQueries(FRAMES_IN_FLIGHT, startQueries);
+		glDeleteQueries(FRAMES_IN_FLIGHT, endQueries);
+	}
+
+	void DynamicResolution::beginFrame()
+	{
+		// skips measuring while the GPU is still behind the frame that last used these queries
+		unsigned int slot = frame % FRAMES_IN_FLIGHT;
+		measuring = !pending[slot];
+		if (!measuring) return;
+		glQueryCounter(startQueries[slot], GL_TIMESTAMP);
+		frameScale[slot] = scale;
+	}
+
+	void DynamicResolution::endFrame()
+	{
+		unsigned int slot = frame % FRAMES_IN_FLIGHT;
+		if (measuring)
+		{
+			glQueryCounter(endQueries[slot], GL_TIMESTAMP);
+			pending[slot] = true;
+		}
+		frame++;
+	}
+
+	bool DynamicResolution::update()
+	{
+		for (unsigned int slot = 0; slot < FRAMES_IN_FLIGHT; slot++)
+		{
+			if (!pending[slot]) continue;
+			GLint available = 0;
+			glGetQueryObjectiv(endQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) continue;
+			pending[slot] = false;
+
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(startQueries[slot], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(endQueries[slot], GL_QUERY_RESULT, &end);
+			if (frameScale[slot] != scale) continue;
+			double time = (end - start) / 1000000.0;
+			gpuTime = measuredAtScale ? gpuTime + (time - gpuTime) * SMOOTHING : time;
+			measuredAtScale = true;
+		}
+
+		float newScale = scale;
+		if (!enabled)
+		{
+			newScale = fixedScale;
+		}
+		else if (measuredAtScale)
+		{
+			float ideal = scale * (float)std::sqrt(budgetMs / gpuTime);
+			ideal = std::max(minScale, std::min(ideal, 1.f));
+			// a step down as soon as the frame is too slow, a step up only with the margin of a whole step
+			if (ideal < scale) newScale = std::max(minScale, std::floor(ideal / SCALE_STEP + 0.001f) * SCALE_STEP);
+			else if (ideal >= scale + SCALE_STEP) newScale = std::min(1.f, std::floor(ideal / SCALE_STEP + 0.001f) * SCALE_STEP);
+		}
+
+		if (newScale == scale) return false;
+		scale = newScale;
+		// waits for a frame at the new scale before the next step
+		measuredAtScale = false;
+		return true;
+	}
+
+	float DynamicResolution::getScale() const { return scale; }
+	double DynamicResolution::getGpuTime() const { return gpuTime; }
+}
\ No newline at end of file
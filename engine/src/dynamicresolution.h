@@ -0,0 +1,52 @@
+#pragma once
+
+#include <GL/glew.h>
+
+namespace engine
+{
+	// Chooses the render scale of the screen viewport from the measured GPU time of the frames. Timestamps around every
+	// frame are read back without stalling once the GPU passed them, a few frames late. The pixel count and with it most
+	// of the frame time grows with the square of the scale, so the scale moves by the square root of the budget over the
+	// measured time. It moves in steps, and only frames rendered at the current scale are measured, so the histories of
+	// the temporal passes are not discarded every frame and the scale does not oscillate.
+	class DynamicResolution
+	{
+	public:
+		// frames whose timestamps can be in flight
+		static const unsigned int FRAMES_IN_FLIGHT = 4;
+		static const float SCALE_STEP;
+
+		DynamicResolution();
+		~DynamicResolution();
+
+		// around the GPU work of a frame
+		void beginFrame();
+		void endFrame();
+
+		// reads back finished frames and picks the scale for the next one, returns true if it changed
+		bool update();
+		float getScale() const;
+		// smoothed GPU time of the frames in milliseconds
+		double getGpuTime() const;
+
+		// on unless switched off, off renders at the fixed scale
+		bool enabled = true;
+		float fixedScale = 1.f;
+		// GPU time per frame to stay within, a little below the 16.7 ms of 60 Hz
+		float budgetMs = 15.f;
+		float minScale = 0.5f;
+	private:
+		GLuint startQueries[FRAMES_IN_FLIGHT] = { 0 };
+		GLuint endQueries[FRAMES_IN_FLIGHT] = { 0 };
+		bool pending[FRAMES_IN_FLIGHT] = { false };
+		// scale the frame of each query pair was rendered at
+		float frameScale[FRAMES_IN_FLIGHT] = { 0.f };
+		unsigned int frame = 0;
+		bool measuring = false;
+
+		float scale = 1.f;
+		double gpuTime = 0.0;
+		// whether the time was measured since the scale last changed
+		bool measuredAtScale = false;
+	};
+}
\ No newline at end of file
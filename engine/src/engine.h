@@ -40,7 +40,7 @@ namespace engine {
         int windowWidth = 1200, windowHeight = 700;
         bool fullscreen = false;
 
-        int glMajor = 3, glMinor = 3;
+        int glMajor = 4, glMinor = 4;
         bool vysnc = true;
 
         void setup();
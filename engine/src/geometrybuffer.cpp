@@ -1,12 +1,48 @@
 #include "geometrybuffer.h"
+#include "shader.h"
 #include <cstddef>
 #include <iostream>
 
 namespace engine {
 
+	const GBufferLayout GBuffer::LAYOUTS[GBuffer::GB_NUMBER_OF_LAYOUTS] = {
+		{ "RGBA16F normals", { GL_RGBA8, GL_RGBA16F, GL_RGBA8 }, false, false, false },
+		{ "RG16 octahedral normals", { GL_RGBA8, GL_RG16, GL_RG8 }, true, true, false },
+		{ "RGB10A2 packed", { GL_RGBA8, GL_RGB10_A2, 0 }, true, true, true }
+	};
+
+	static unsigned int formatBytes(GLenum format) {
+		switch (format) {
+		case GL_RG8: return 2;
+		case GL_RGBA8:
+		case GL_RG16:
+		case GL_RGB10_A2:
+		case GL_DEPTH24_STENCIL8: return 4;
+		case GL_RGBA16F: return 8;
+		default: return 0;
+		}
+	}
+
+	unsigned int GBufferLayout::getBytesPerPixel() const {
+		unsigned int bytes = formatBytes(GL_DEPTH24_STENCIL8);
+		for (GLenum format : formats)
+			bytes += formatBytes(format);
+		return bytes;
+	}
+
+	std::vector<std::string> GBufferLayout::getShaderDefines() const {
+		std::vector<std::string> defines;
+		if (octahedralNormals) defines.push_back("GBUFFER_OCTAHEDRAL_NORMALS");
+		if (aoInAlbedo) defines.push_back("GBUFFER_AO_IN_ALBEDO");
+		if (materialInNormal) defines.push_back("GBUFFER_MATERIAL_IN_NORMAL");
+		return defines;
+	}
+
 	GBuffer::GBuffer() {
 		fbo = 0;
 		depthTexture = 0;
+		for (GLuint& tex : texture)
+			tex = 0;
 	}
 
 	GBuffer::~GBuffer() {
@@ -23,19 +59,24 @@ namespace engine {
 	}
 
 	void GBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight) {
-		
+
+		const GBufferLayout& bufferLayout = getLayout();
+
 		// Geometry FBO
 		glGenFramebuffers(1, &fbo);
 		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 		glGenTextures(GBuffer::GB_NUMBER_OF_TEXTURES, texture);
 		glGenTextures(1, &depthTexture);
-		
+
+		GLenum DrawBuffers[GBuffer::GB_NUMBER_OF_TEXTURES];
 		for (unsigned int i = 0; i < GBuffer::GB_NUMBER_OF_TEXTURES; i++) {
+			// targets the layout does not use stay without storage and are not drawn to
+			DrawBuffers[i] = bufferLayout.formats[i] != 0 ? GL_COLOR_ATTACHMENT0 + i : GL_NONE;
+			if (bufferLayout.formats[i] == 0)
+				continue;
+
 			glBindTexture(GL_TEXTURE_2D, texture[i]);
-			if (i == GBuffer::GB_METALLIC_ROUGHNESS_AO || i == GBuffer::GB_ALBEDO) 
-				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-			else 
-				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+			glTexImage2D(GL_TEXTURE_2D, 0, bufferLayout.formats[i], windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
 
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -43,14 +84,34 @@ namespace engine {
 		}
 
 		glBindTexture(GL_TEXTURE_2D, depthTexture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, windowWidth, windowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
-		GLenum DrawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
-		glDrawBuffers(4, DrawBuffers);
+		// with stencil so the light volume passes can use the same format
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, windowWidth, windowHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+		glDrawBuffers(GBuffer::GB_NUMBER_OF_TEXTURES, DrawBuffers);
 
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
+	void GBuffer::bindTextures() const {
+		for (unsigned int i = 0; i < GBuffer::GB_NUMBER_OF_TEXTURES; i++) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D, getLayout().formats[i] != 0 ? texture[i] : 0);
+		}
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+	}
+
+	void GBuffer::updateShader(ShaderProgram* program) const {
+		program->use();
+		program->setUniform("gAlbedo", GBuffer::GB_ALBEDO);
+		program->setUniform("gNormal", GBuffer::GB_NORMAL);
+		program->setUniform("gMetallicRoughnessAO", GBuffer::GB_METALLIC_ROUGHNESS_AO);
+		program->setUniform("gDepth", GBuffer::GB_DEPTH_UNIT);
+		program->unuse();
+	}
+
 	void GBuffer::setBufferToRead(GB_TEX_TYPE texType) {
 		glReadBuffer(GL_COLOR_ATTACHMENT0 + texType);
 	}
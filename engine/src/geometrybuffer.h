@@ -1,27 +1,73 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <string>
+#include <vector>
 
 namespace engine {
 
-	class GBuffer 
+	class ShaderProgram;
+
+	// internal formats and encodings of the GBuffer targets
+	struct GBufferLayout
+	{
+		const char* name;
+		// one format per GBuffer::GB_TEX_TYPE, 0 if the layout keeps that data in another target
+		GLenum formats[3];
+		// two channel octahedral normals instead of a normal vector
+		bool octahedralNormals;
+		// ambient occlusion in the alpha channel of the albedo target
+		bool aoInAlbedo;
+		// roughness and metallic in the blue and alpha channel of the normal target
+		bool materialInNormal;
+
+		// color targets and the depth stencil texture
+		unsigned int getBytesPerPixel() const;
+		// selects the matching encode and decode in gbuffer.glsl
+		std::vector<std::string> getShaderDefines() const;
+	};
+
+	class GBuffer
 	{
 	public:
-		enum GB_TEX_TYPE 
+		// there is no position target, it is reconstructed from the depth texture
+		enum GB_TEX_TYPE
 		{
-			GB_POSITION,
 			GB_ALBEDO,
 			GB_NORMAL,
 			GB_METALLIC_ROUGHNESS_AO,
-			GB_NUMBER_OF_TEXTURES		// Not a texture type, but used to count textures 
+			GB_NUMBER_OF_TEXTURES		// Not a texture type, but used to count textures
+		};
+
+		enum GB_LAYOUT
+		{
+			GB_LAYOUT_WIDE,				// RGBA16F normals and a separate metallic/roughness/AO target
+			GB_LAYOUT_OCTAHEDRAL,		// RG16 octahedral normals, AO next to the albedo, RG8 metallic/roughness
+			GB_LAYOUT_PACKED,			// RGB10A2 octahedral normals with roughness and a 2 bit metallic, AO next to the albedo
+			GB_NUMBER_OF_LAYOUTS
 		};
 
+		static const GBufferLayout LAYOUTS[GB_NUMBER_OF_LAYOUTS];
+
+		// texture unit of the depth texture in passes reading the whole GBuffer, right after the color targets
+		static const int GB_DEPTH_UNIT = GB_NUMBER_OF_TEXTURES;
+
 		GBuffer();
 		~GBuffer();
 
+		// takes effect with the next initialize, programs reading the GBuffer need to be rebuilt with the new defines
+		GB_LAYOUT layout = GB_LAYOUT_OCTAHEDRAL;
+		const GBufferLayout& getLayout() const { return LAYOUTS[layout]; }
+		std::vector<std::string> getShaderDefines() const { return getLayout().getShaderDefines(); }
+
 		void initialize(unsigned int windowWidth, unsigned int windowHeight);
 		void deleteBufferData();
 
+		// binds the color targets to their units and the depth texture to GB_DEPTH_UNIT
+		void bindTextures() const;
+		// points the samplers of gbuffer.glsl at the units used by bindTextures
+		void updateShader(ShaderProgram* program) const;
+
 		void setBufferToRead(GB_TEX_TYPE texType);
 
 		GLuint fbo;
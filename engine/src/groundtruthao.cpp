@@ -0,0 +1,134 @@
+#include "groundtruthao.h"
+
+namespace engine
+{
+	static std::vector<std::string> getShaderDefines()
+	{
+		return {
+			"GROUP_SIZE " + std::to_string(GroundTruthAO::GROUP_SIZE),
+			"DEPTH_MIP_LEVELS " + std::to_string(GroundTruthAO::DEPTH_MIP_LEVELS)
+		};
+	}
+
+	// texture unit of the depth pyramid, the GBuffer uses the units up to GB_DEPTH_UNIT
+	const int DEPTH_PYRAMID_UNIT = GBuffer::GB_DEPTH_UNIT + 1;
+
+	GroundTruthAO::GroundTruthAO(const Camera* camera, const GBuffer* gbuffer, const ScreenViewport* viewport, const TileClassification* tiles) :
+		gbuffer(gbuffer), viewport(viewport), tiles(tiles)
+	{
+		std::vector<std::string> defines = getShaderDefines();
+
+		depthProgram = new ShaderProgram();
+		depthProgram->initCompute("shaders/postprocessing/gtaoDepth.comp", defines);
+		depthProgram->link();
+		depthProgram->use();
+		depthProgram->setUniform("gDepth", GBuffer::GB_DEPTH_UNIT);
+		depthProgram->unuse();
+
+		std::vector<std::string> gbufferDefines = gbuffer->getShaderDefines();
+		defines.insert(defines.end(), gbufferDefines.begin(), gbufferDefines.end());
+		std::vector<std::string> tileDefines = TileClassification::getShaderDefines();
+		defines.insert(defines.end(), tileDefines.begin(), tileDefines.end());
+		defines.push_back("TILE_LIST");
+
+		horizonProgram = new ShaderProgram();
+		horizonProgram->initCompute("shaders/postprocessing/gtao.comp", defines);
+		horizonProgram->link();
+		horizonProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+		gbuffer->updateShader(horizonProgram);
+		horizonProgram->use();
+		horizonProgram->setUniform("depthPyramid", DEPTH_PYRAMID_UNIT);
+		horizonProgram->unuse();
+
+		denoiseProgram = new ShaderProgram();
+		denoiseProgram->initCompute("shaders/postprocessing/gtaoDenoise.comp", getShaderDefines());
+		denoiseProgram->link();
+	}
+
+	GroundTruthAO::~GroundTruthAO()
+	{
+		deleteBufferData();
+		delete depthProgram;
+		delete horizonProgram;
+		delete denoiseProgram;
+	}
+
+	void GroundTruthAO::initialize(unsigned int windowWidth, unsigned int windowHeight)
+	{
+		// the target sizes are multiples of the bucket size, every mip halves exactly
+		glGenTextures(1, &depthPyramid);
+		glBindTexture(GL_TEXTURE_2D, depthPyramid);
+		glTexStorage2D(GL_TEXTURE_2D, DEPTH_MIP_LEVELS, GL_R32F, windowWidth, windowHeight);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	void GroundTruthAO::deleteBufferData()
+	{
+		if (depthPyramid != 0)
+		{
+			glDeleteTextures(1, &depthPyramid);
+			depthPyramid = 0;
+		}
+	}
+
+	void GroundTruthAO::dispatch(unsigned int width, unsigned int height)
+	{
+		glDispatchCompute((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+		// the next dispatch loads the images, the lighting pass samples the result
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+
+	void GroundTruthAO::buildDepthPyramid(const Matrix4& projectionMatrix)
+	{
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT);
+		glBindTexture(GL_TEXTURE_2D, gbuffer->depthTexture);
+
+		depthProgram->use();
+		// m22 and m23 of a perspective projection
+		depthProgram->setUniform("depthLinearize", Vector2(projectionMatrix.data[10], projectionMatrix.data[14]));
+		for (unsigned int level = 0; level < DEPTH_MIP_LEVELS; level++)
+		{
+			// every level reduces the one before, the first one reads the depth texture
+			glBindImageTexture(0, depthPyramid, level == 0 ? 0 : level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(1, depthPyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			depthProgram->setUniform("level", (int)level);
+			unsigned int scale = 1u << level;
+			dispatch((viewport->getWidth() + scale - 1) / scale, (viewport->getHeight() + scale - 1) / scale);
+		}
+		depthProgram->unuse();
+	}
+
+	void GroundTruthAO::computeOcclusion(GLuint occlusionTexture)
+	{
+		// sky only tiles are not dispatched, they keep the value of the background
+		const GLfloat background[4] = { 1.f, 0.f, 0.f, 0.f };
+		glClearTexImage(occlusionTexture, 0, GL_RG, GL_FLOAT, background);
+
+		gbuffer->bindTextures();
+		glActiveTexture(GL_TEXTURE0 + DEPTH_PYRAMID_UNIT);
+		glBindTexture(GL_TEXTURE_2D, depthPyramid);
+		glBindImageTexture(0, occlusionTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+
+		horizonProgram->use();
+		horizonProgram->setUniform("sliceCount", sliceCount);
+		horizonProgram->setUniform("stepCount", stepCount);
+		horizonProgram->setUniform("radius", radius);
+		tiles->dispatchTiles(TileClassification::GEOMETRY_TILES);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+		horizonProgram->unuse();
+	}
+
+	void GroundTruthAO::denoise(GLuint occlusionTexture, GLuint destinationTexture)
+	{
+		glBindImageTexture(0, occlusionTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG16F);
+		glBindImageTexture(1, destinationTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+
+		denoiseProgram->use();
+		dispatch(viewport->getWidth(), viewport->getHeight());
+		denoiseProgram->unuse();
+	}
+}
\ No newline at end of file
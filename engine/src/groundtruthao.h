@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "camera.h"
+#include "geometrybuffer.h"
+#include "screenviewport.h"
+#include "shader.h"
+#include "tileclassification.h"
+
+namespace engine
+{
+	// Horizon based ambient occlusion in compute shaders, an alternative to the hemisphere kernel of the SSAO pass.
+	// A mip pyramid of linear depth is built from the GBuffer, then every pixel searches the highest horizon on both
+	// sides of a few screen space directions, reading coarser mips the further it steps, and integrates the cosine
+	// weighted visible arc between them. The directions are rotated in a 4x4 pattern that a 4x4 depth aware filter
+	// through shared memory averages away again. The result is the same occlusion target the SSAO pass writes.
+	class GroundTruthAO
+	{
+	public:
+		static const unsigned int GROUP_SIZE = 8;
+		static const unsigned int DEPTH_MIP_LEVELS = 5;
+
+		// the horizon search decodes the normals of the current layout of gbuffer, create a new instance when it changes,
+		// it only runs on the geometry tiles of tiles
+		GroundTruthAO(const Camera* camera, const GBuffer* gbuffer, const ScreenViewport* viewport, const TileClassification* tiles);
+		~GroundTruthAO();
+
+		// allocates the depth pyramid for targets this large
+		void initialize(unsigned int windowWidth, unsigned int windowHeight);
+		void deleteBufferData();
+
+		// linear view space depth of the GBuffer and its mips, only the viewport is filled
+		void buildDepthPyramid(const Matrix4& projectionMatrix);
+		// visibility and linear depth into a GL_RG16F texture the size of the targets, of the last classified tiles
+		void computeOcclusion(GLuint occlusionTexture);
+		// filtered visibility into a GL_R8 texture the size of the targets
+		void denoise(GLuint occlusionTexture, GLuint destinationTexture);
+
+		// directions searched per pixel and steps to each side, the radius is in view space
+		int sliceCount = 2;
+		int stepCount = 4;
+		float radius = 0.5f;
+
+		GLuint depthPyramid = 0;
+	private:
+		void dispatch(unsigned int width, unsigned int height);
+
+		const GBuffer* gbuffer;
+		const ScreenViewport* viewport;
+		const TileClassification* tiles;
+
+		ShaderProgram* depthProgram = nullptr;
+		ShaderProgram* horizonProgram = nullptr;
+		ShaderProgram* denoiseProgram = nullptr;
+	};
+}
\ No newline at end of file
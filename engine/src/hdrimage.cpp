@@ -0,0 +1,323 @@
+#include "hdrimage.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+
+#include "exceptions.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HDR_USE_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HDR_TARGET_F16C
+#else
+#include <cpuid.h>
+#define HDR_TARGET_F16C __attribute__((target("f16c")))
+#endif
+#endif
+
+namespace engine
+{
+	namespace
+	{
+		// Radiance scanlines start with 2, 2 followed by the big endian width if they are run length encoded.
+		bool isRleScanline(const unsigned char* scanline, int width)
+		{
+			return scanline[0] == 2 && scanline[1] == 2 && (scanline[2] & 0x80) == 0 && ((scanline[2] << 8) | scanline[3]) == width;
+		}
+
+		bool readLine(const std::vector<unsigned char>& file, size_t& pos, std::string& line)
+		{
+			line.clear();
+			while (pos < file.size() && file[pos] != '\n')
+			{
+				line.push_back(static_cast<char>(file[pos++]));
+			}
+			if (pos >= file.size()) return false;
+			pos++;
+			return true;
+		}
+
+		/* RGBE -> half conversion */
+		uint16_t floatToHalf(float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+
+			// RGBE values are never negative, NaN or infinite, so only overflow and underflow need handling
+			uint32_t exponent = (bits >> 23) & 0xff;
+			uint32_t mantissa = bits & 0x7fffff;
+			if (exponent > 142) return 0x7bff;
+			if (exponent < 103) return 0;
+			if (exponent < 113)
+			{
+				// subnormal half, round to nearest even
+				mantissa |= 0x800000;
+				uint32_t shift = 126 - exponent;
+				uint32_t half = mantissa >> shift;
+				uint32_t rest = mantissa & ((1u << shift) - 1);
+				uint32_t halfway = 1u << (shift - 1);
+				if (rest > halfway || (rest == halfway && (half & 1))) half++;
+				return static_cast<uint16_t>(half);
+			}
+			uint32_t half = ((exponent - 112) << 10) | (mantissa >> 13);
+			uint32_t rest = mantissa & 0x1fff;
+			if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+			return static_cast<uint16_t>(std::min(half, 0x7bffu));
+		}
+
+#ifndef HDR_USE_SSE
+		void convertRowScalar(const unsigned char* rgbe, uint16_t* rgb, int width)
+		{
+			for (int x = 0; x < width; x++, rgbe += 4, rgb += 3)
+			{
+				if (rgbe[3] == 0)
+				{
+					rgb[0] = rgb[1] = rgb[2] = 0;
+					continue;
+				}
+				float scale = std::ldexp(1.0f, rgbe[3] - (128 + 8));
+				rgb[0] = floatToHalf(rgbe[0] * scale);
+				rgb[1] = floatToHalf(rgbe[1] * scale);
+				rgb[2] = floatToHalf(rgbe[2] * scale);
+			}
+		}
+#else
+		bool cpuSupportsF16C()
+		{
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			return (info[2] & (1 << 29)) != 0;
+#else
+			unsigned int eax, ebx, ecx, edx;
+			if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+			return (ecx & (1u << 29)) != 0;
+#endif
+		}
+
+		// Builds the factor 2^(e - 136) directly in the float exponent field.
+		// Exponents below 10 would give denormal floats and are flushed to zero, they are zero as halfs anyway.
+		inline __m128 rgbeToFloat(const unsigned char* rgbe)
+		{
+			int packed;
+			std::memcpy(&packed, rgbe, sizeof(packed));
+
+			const __m128i zero = _mm_setzero_si128();
+			__m128i pixel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+			__m128i exponent = _mm_shuffle_epi32(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+			__m128i biased = _mm_and_si128(_mm_sub_epi32(exponent, _mm_set1_epi32(9)), _mm_cmpgt_epi32(exponent, _mm_set1_epi32(9)));
+			__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(biased, 23));
+
+			// clamp to the largest half so overly bright pixels don't turn into infinity
+			return _mm_min_ps(_mm_mul_ps(_mm_cvtepi32_ps(pixel), scale), _mm_set1_ps(65504.0f));
+		}
+
+		HDR_TARGET_F16C void convertRowF16C(const unsigned char* rgbe, uint16_t* rgb, int width)
+		{
+			// two pixels per iteration, the last one is done separately to not write past the row
+			int x = 0;
+			for (; x + 2 < width; x += 2, rgbe += 8, rgb += 6)
+			{
+				__m128i a = _mm_cvtps_ph(rgbeToFloat(rgbe), _MM_FROUND_TO_NEAREST_INT);
+				__m128i b = _mm_cvtps_ph(rgbeToFloat(rgbe + 4), _MM_FROUND_TO_NEAREST_INT);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(rgb), a);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(rgb + 3), b);
+			}
+			for (; x < width; x++, rgbe += 4, rgb += 3)
+			{
+				alignas(16) uint16_t half[8];
+				_mm_store_si128(reinterpret_cast<__m128i*>(half), _mm_cvtps_ph(rgbeToFloat(rgbe), _MM_FROUND_TO_NEAREST_INT));
+				std::memcpy(rgb, half, 3 * sizeof(uint16_t));
+			}
+		}
+
+		void convertRowSSE(const unsigned char* rgbe, uint16_t* rgb, int width)
+		{
+			alignas(16) float values[4];
+			for (int x = 0; x < width; x++, rgbe += 4, rgb += 3)
+			{
+				_mm_store_ps(values, rgbeToFloat(rgbe));
+				rgb[0] = floatToHalf(values[0]);
+				rgb[1] = floatToHalf(values[1]);
+				rgb[2] = floatToHalf(values[2]);
+			}
+		}
+#endif
+
+		using ConvertRowFunction = void (*)(const unsigned char*, uint16_t*, int);
+
+		ConvertRowFunction selectRowConversion()
+		{
+#ifdef HDR_USE_SSE
+			static const bool hasF16C = cpuSupportsF16C();
+			return hasF16C ? convertRowF16C : convertRowSSE;
+#else
+			return convertRowScalar;
+#endif
+		}
+
+		/* Scanline decoding */
+		// Finds the end of a run length encoded scanline, returns 0 if the data is corrupt.
+		size_t skipRleScanline(const std::vector<unsigned char>& file, size_t pos, int width)
+		{
+			pos += 4;
+			for (int component = 0; component < 4; component++)
+			{
+				int count = 0;
+				while (count < width)
+				{
+					if (pos >= file.size()) return 0;
+					int length = file[pos++];
+					if (length > 128)
+					{
+						length -= 128;
+						pos += 1;
+					}
+					else
+					{
+						pos += length;
+					}
+					if (length == 0 || count + length > width || pos > file.size()) return 0;
+					count += length;
+				}
+			}
+			return pos;
+		}
+
+		void decodeRleScanline(const unsigned char* data, unsigned char* rgbe, int width)
+		{
+			data += 4;
+			for (int component = 0; component < 4; component++)
+			{
+				unsigned char* out = rgbe + component;
+				int count = 0;
+				while (count < width)
+				{
+					int length = *data++;
+					if (length > 128)
+					{
+						length -= 128;
+						unsigned char value = *data++;
+						for (int i = 0; i < length; i++, out += 4) *out = value;
+					}
+					else
+					{
+						for (int i = 0; i < length; i++, out += 4) *out = *data++;
+					}
+					count += length;
+				}
+			}
+		}
+	}
+
+	bool loadRadianceHDR(const std::string& filename, HdrImage& image, bool flipVertically)
+	{
+		std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+		if (!stream.is_open())
+		{
+			throw FileCouldNotBeOpenedException(filename.c_str());
+		}
+
+		std::vector<unsigned char> file(static_cast<size_t>(stream.tellg()));
+		stream.seekg(0);
+		stream.read(reinterpret_cast<char*>(file.data()), file.size());
+		stream.close();
+
+		/* Header */
+		size_t pos = 0;
+		std::string line;
+		if (!readLine(file, pos, line) || (line != "#?RADIANCE" && line != "#?RGBE"))
+		{
+			return false;
+		}
+
+		while (readLine(file, pos, line) && !line.empty())
+		{
+			if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+			{
+				throw Exception("Unsupported Radiance pixel format in '" + filename + "'.");
+			}
+		}
+
+		int width = 0, height = 0;
+		char yAxis[3] = {}, xAxis[3] = {};
+		if (!readLine(file, pos, line) || std::sscanf(line.c_str(), "%2s %d %2s %d", yAxis, &height, xAxis, &width) != 4
+			|| std::strcmp(yAxis, "-Y") != 0 || std::strcmp(xAxis, "+X") != 0 || width <= 0 || height <= 0)
+		{
+			throw Exception("Unsupported Radiance image orientation in '" + filename + "'.");
+		}
+
+		/* Scanline offsets (sequential, the encoded size of a scanline is only known after walking its runs) */
+		const size_t rowBytes = static_cast<size_t>(width) * 4;
+		std::vector<size_t> offsets(height);
+		int firstFlatRow = height;
+		for (int y = 0; y < height; y++)
+		{
+			offsets[y] = pos;
+			if (width < 8 || width > 0x7fff || pos + 4 > file.size() || !isRleScanline(&file[pos], width))
+			{
+				// like stb_image, anything not run length encoded switches to flat RGBE for the rest of the file
+				firstFlatRow = y;
+				break;
+			}
+			pos = skipRleScanline(file, pos, width);
+			if (pos == 0)
+			{
+				throw Exception("Corrupt run length encoding in '" + filename + "'.");
+			}
+		}
+		for (int y = firstFlatRow; y < height; y++)
+		{
+			offsets[y] = pos;
+			pos += rowBytes;
+		}
+		if (pos > file.size())
+		{
+			throw Exception("Unexpected end of file in '" + filename + "'.");
+		}
+
+		/* Parallel decode */
+		image.width = width;
+		image.height = height;
+		image.data.resize(static_cast<size_t>(width) * height * 3);
+
+		const ConvertRowFunction convertRow = selectRowConversion();
+		auto decodeRows = [&](int begin, int end)
+		{
+			std::vector<unsigned char> rgbe(rowBytes);
+			for (int y = begin; y < end; y++)
+			{
+				const unsigned char* source = &file[offsets[y]];
+				if (y < firstFlatRow)
+				{
+					decodeRleScanline(source, rgbe.data(), width);
+					source = rgbe.data();
+				}
+				int row = flipVertically ? height - 1 - y : y;
+				convertRow(source, &image.data[static_cast<size_t>(row) * width * 3], width);
+			}
+		};
+
+		const int threadCount = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), height / 16));
+		const int rowsPerThread = (height + threadCount - 1) / threadCount;
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; i++)
+		{
+			int begin = i * rowsPerThread;
+			threads.emplace_back(decodeRows, begin, std::min(begin + rowsPerThread, height));
+		}
+		decodeRows(0, std::min(rowsPerThread, height));
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace engine
+{
+	// Radiance RGBE image decoded to tightly packed RGB half floats (GL_RGB / GL_HALF_FLOAT).
+	struct HdrImage
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<uint16_t> data;
+	};
+
+	// Decodes a Radiance .hdr file using all available cores.
+	// Returns false if the file is not a Radiance file, throws if it cannot be read or is corrupt.
+	bool loadRadianceHDR(const std::string& filename, HdrImage& image, bool flipVertically = true);
+}
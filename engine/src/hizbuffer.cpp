@@ -0,0 +1,70 @@
+#include "hizbuffer.h"
+
+#include <string>
+#include <vector>
+
+namespace engine
+{
+	HiZBuffer::HiZBuffer(const ScreenViewport* viewport, Reduction reduction) : viewport(viewport)
+	{
+		std::vector<std::string> defines = { "GROUP_SIZE " + std::to_string(GROUP_SIZE) };
+		if (reduction == FARTHEST_DEPTH) defines.push_back("FARTHEST_DEPTH");
+
+		program = new ShaderProgram();
+		program->initCompute("shaders/general/hiZ.comp", defines);
+		program->link();
+		program->use();
+		program->setUniform("depthTexture", 0);
+		program->unuse();
+	}
+
+	HiZBuffer::~HiZBuffer()
+	{
+		deleteBufferData();
+		delete program;
+	}
+
+	void HiZBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight)
+	{
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexStorage2D(GL_TEXTURE_2D, LEVELS, GL_R32F, windowWidth, windowHeight);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	void HiZBuffer::deleteBufferData()
+	{
+		if (texture != 0)
+		{
+			glDeleteTextures(1, &texture);
+			texture = 0;
+		}
+	}
+
+	void HiZBuffer::build(GLuint depthTexture)
+	{
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+		program->use();
+		for (unsigned int level = 0; level < LEVELS; level++)
+		{
+			// every level reduces the one before, the first one copies the depth texture
+			glBindImageTexture(0, texture, level == 0 ? 0 : level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(1, texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			program->setUniform("level", (int)level);
+
+			unsigned int scale = 1u << level;
+			unsigned int width = (viewport->getWidth() + scale - 1) / scale;
+			unsigned int height = (viewport->getHeight() + scale - 1) / scale;
+			glDispatchCompute((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+			// the next level loads this one, the consumers sample the finished pyramid
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+		}
+		program->unuse();
+	}
+}
\ No newline at end of file
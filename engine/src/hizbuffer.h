@@ -0,0 +1,38 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "screenviewport.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Hierarchical depth buffer: a mip chain of the GBuffer depth in which every texel holds the closest depth of the
+	// four texels below it. A ray that stays in front of the value of a coarse texel cannot hit anything in the whole
+	// region, which lets tracing skip empty space. Built from the farthest depth instead, a bounding box behind the value
+	// of a coarse texel is hidden in the whole region, which lets culling reject whole objects.
+	// Depths are stored as in the depth buffer, only the viewport of the screen targets is filled.
+	class HiZBuffer
+	{
+	public:
+		static const unsigned int GROUP_SIZE = 8;
+		// down to a single texel per bucket of the screen targets, every level halves exactly
+		static const unsigned int LEVELS = 9;
+
+		enum Reduction { CLOSEST_DEPTH, FARTHEST_DEPTH };
+
+		HiZBuffer(const ScreenViewport* viewport, Reduction reduction = CLOSEST_DEPTH);
+		~HiZBuffer();
+
+		void initialize(unsigned int windowWidth, unsigned int windowHeight);
+		void deleteBufferData();
+
+		// rebuilds every level from a depth texture the size of the targets
+		void build(GLuint depthTexture);
+
+		GLuint texture = 0;
+	private:
+		const ScreenViewport* viewport;
+		ShaderProgram* program = nullptr;
+	};
+}
\ No newline at end of file
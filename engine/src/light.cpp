@@ -1,5 +1,8 @@
 #include "light.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace engine
 {
 	Light::Light(Vector3 position, Vector3 color, float brightness)
@@ -8,4 +11,10 @@ namespace engine
 		this->color = color;
 		this->brightness = brightness;
 	}
+
+	float Light::getRadius() const
+	{
+		float intensity = brightness * std::max(color.x, std::max(color.y, color.z));
+		return std::sqrt(std::max(intensity, 0.f) / LIGHT_ATTENUATION_CUTOFF);
+	}
 }
\ No newline at end of file
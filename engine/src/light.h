@@ -4,11 +4,21 @@
 
 namespace engine
 {
+	// radiance below which a light is considered to have no influence, used to give lights a finite radius
+	const float LIGHT_ATTENUATION_CUTOFF = 0.05f;
+
+	// only point lights are shaded so far, the type is stored with every light in the light buffer
+	enum LightType { POINT_LIGHT = 0 };
+
 	struct Light
 	{
 		Light(Vector3 position, Vector3 color, float brightness);
 		Vector3 position;
 		Vector3 color;
 		float brightness = 1.f;
+		LightType type = POINT_LIGHT;
+
+		// distance at which the inverse square falloff drops below LIGHT_ATTENUATION_CUTOFF
+		float getRadius() const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "lightbuffer.h"
+
+#include <algorithm>
+
+namespace engine
+{
+	// matches the std430 layout of Light in lights.glsl
+	struct GpuLight
+	{
+		float position[3];
+		float radius;
+		float color[3];
+		uint32_t type;
+	};
+
+	const uint8_t ALL_REGIONS = (1 << LightBuffer::FRAME_COUNT) - 1;
+
+	LightBuffer::~LightBuffer()
+	{
+		deleteBufferData();
+	}
+
+	void LightBuffer::add(const Light& light)
+	{
+		lights.push_back(light);
+		staleRegions.push_back(0);
+		markDirty(lights.size() - 1);
+	}
+
+	void LightBuffer::remove(size_t index)
+	{
+		size_t last = lights.size() - 1;
+		if (index != last)
+		{
+			lights[index] = lights[last];
+			markDirty(index);
+		}
+		lights.pop_back();
+		staleRegions.pop_back();
+	}
+
+	void LightBuffer::set(size_t index, const Light& light)
+	{
+		lights[index] = light;
+		markDirty(index);
+	}
+
+	void LightBuffer::markDirty(size_t index)
+	{
+		if (staleRegions[index] == 0)
+		{
+			dirtyLights.push_back((uint32_t)index);
+		}
+		staleRegions[index] = ALL_REGIONS;
+	}
+
+	void LightBuffer::allocate(size_t minCapacity)
+	{
+		deleteBufferData();
+
+		GLint alignment = 1;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+		capacity = std::max(minCapacity, std::max(capacity * 2, (size_t)64));
+		regionSize = (GLsizeiptr)(capacity * sizeof(GpuLight));
+		regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+		// coherent mapping, writes become visible to the GPU without explicit flushes
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, regionSize * FRAME_COUNT, nullptr, flags);
+		mappedData = (unsigned char*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, regionSize * FRAME_COUNT, flags);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		// a new buffer holds no lights in any region
+		dirtyLights.clear();
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			staleRegions[i] = ALL_REGIONS;
+			dirtyLights.push_back((uint32_t)i);
+		}
+	}
+
+	void LightBuffer::deleteBufferData()
+	{
+		for (GLsync& fence : fences)
+		{
+			if (fence)
+			{
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+		if (buffer != 0)
+		{
+			// the storage stays alive until the GPU has finished reading it
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+			glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			glDeleteBuffers(1, &buffer);
+			buffer = 0;
+			mappedData = nullptr;
+		}
+		currentRegion = -1;
+	}
+
+	void LightBuffer::waitForRegion(unsigned int region)
+	{
+		if (!fences[region]) return;
+
+		// only blocks if the CPU is more than FRAME_COUNT - 1 frames ahead of the GPU
+		GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		glDeleteSync(fences[region]);
+		fences[region] = nullptr;
+	}
+
+	void LightBuffer::update()
+	{
+		if (buffer == 0 || lights.size() > capacity)
+		{
+			allocate(lights.size());
+		}
+
+		// every command of the previous frame, including the ones reading its region, has been issued by now
+		if (currentRegion >= 0)
+		{
+			fences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		currentRegion = (currentRegion + 1) % (int)FRAME_COUNT;
+		waitForRegion(currentRegion);
+
+		// write the lights this region has not seen yet, lights stay in the list until all regions are up to date
+		const uint8_t regionBit = (uint8_t)(1 << currentRegion);
+		GpuLight* region = (GpuLight*)(mappedData + currentRegion * regionSize);
+		size_t remaining = 0;
+		for (uint32_t index : dirtyLights)
+		{
+			// removed lights may still be listed
+			if (index >= lights.size()) continue;
+
+			if (staleRegions[index] & regionBit)
+			{
+				const Light& light = lights[index];
+				Vector3 color = light.color * light.brightness;
+				region[index] = { { light.position.x, light.position.y, light.position.z }, light.getRadius(), { color.x, color.y, color.z }, (uint32_t)light.type };
+				staleRegions[index] &= (uint8_t)~regionBit;
+			}
+			if (staleRegions[index] != 0)
+			{
+				dirtyLights[remaining++] = index;
+			}
+		}
+		dirtyLights.resize(remaining);
+
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, BINDING_POINT, buffer, currentRegion * regionSize, regionSize);
+	}
+}
\ No newline at end of file
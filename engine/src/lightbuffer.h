@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+#include "light.h"
+
+namespace engine
+{
+	// Owns the scene lights and mirrors them into a persistently mapped shader storage buffer.
+	// The buffer is split into FRAME_COUNT regions so the CPU never writes a region the GPU may still read,
+	// only lights that changed since a region was last written are copied into it.
+	class LightBuffer
+	{
+	public:
+		// shader storage binding point of the light array, fixed in lights.glsl
+		static const GLuint BINDING_POINT = 0;
+		static const unsigned int FRAME_COUNT = 3;
+
+		~LightBuffer();
+
+		void add(const Light& light);
+		// swaps the last light into the removed slot, so indices of other lights stay valid
+		void remove(size_t index);
+		void set(size_t index, const Light& light);
+
+		const Light& operator[](size_t index) const { return lights[index]; }
+		size_t size() const { return lights.size(); }
+		bool empty() const { return lights.empty(); }
+
+		// copies dirty lights into the next region and binds it, call once per frame before any pass reads the lights
+		void update();
+		void deleteBufferData();
+	private:
+		void markDirty(size_t index);
+		void allocate(size_t minCapacity);
+		void waitForRegion(unsigned int region);
+
+		std::vector<Light> lights;
+
+		// per light a bit for every region that still holds outdated data
+		std::vector<uint8_t> staleRegions;
+		std::vector<uint32_t> dirtyLights;
+
+		GLuint buffer = 0;
+		unsigned char* mappedData = nullptr;
+		size_t capacity = 0;
+		GLsizeiptr regionSize = 0;
+		GLsync fences[FRAME_COUNT] = {};
+		int currentRegion = -1;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "lightculling.h"
+
+namespace engine
+{
+	/* LightCulling */
+	LightCulling::LightCulling(const char* computeShaderFilename, const std::vector<std::string>& defines, const Camera* camera, const LightBuffer* lights) : lights(lights)
+	{
+		program = new ShaderProgram();
+		program->initCompute(computeShaderFilename, defines);
+		program->link();
+		program->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+	}
+
+	LightCulling::~LightCulling()
+	{
+		deleteBufferData();
+		delete program;
+	}
+
+	void LightCulling::deleteBufferData()
+	{
+		if (cellBuffer != 0)
+		{
+			glDeleteBuffers(1, &cellBuffer);
+			cellBuffer = 0;
+		}
+	}
+
+	void LightCulling::createCellBuffer(unsigned int cellCount, unsigned int maxLightsPerCell)
+	{
+		GLsizeiptr size = (GLsizeiptr)cellCount * (maxLightsPerCell + 1) * sizeof(GLuint);
+
+		glGenBuffers(1, &cellBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	void LightCulling::dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ)
+	{
+		// the lighting pass reads from the same binding point
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CELL_BUFFER_BP, cellBuffer);
+
+		program->setUniform("lightCount", (int)lights->size());
+		glDispatchCompute(groupsX, groupsY, groupsZ);
+
+		// cell lists are read by the lighting pass
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	/* TiledLightCulling */
+	TiledLightCulling::TiledLightCulling(const Camera* camera, const LightBuffer* lights) : LightCulling("shaders/general/lightCulling.comp", getShaderDefines(), camera, lights)
+	{
+		program->use();
+		program->setUniform("gDepth", 0);
+		program->unuse();
+	}
+
+	std::vector<std::string> TiledLightCulling::getShaderDefines()
+	{
+		return {
+			"TILED_LIGHTING",
+			"TILE_SIZE " + std::to_string(TILE_SIZE),
+			"MAX_LIGHTS_PER_TILE " + std::to_string(MAX_LIGHTS_PER_TILE)
+		};
+	}
+
+	void TiledLightCulling::initialize(unsigned int windowWidth, unsigned int windowHeight)
+	{
+		tileCountX = (windowWidth + TILE_SIZE - 1) / TILE_SIZE;
+		tileCountY = (windowHeight + TILE_SIZE - 1) / TILE_SIZE;
+		createCellBuffer(tileCountX * tileCountY, MAX_LIGHTS_PER_TILE);
+	}
+
+	void TiledLightCulling::setViewportSize(unsigned int viewportWidth, unsigned int viewportHeight)
+	{
+		tileCountX = (viewportWidth + TILE_SIZE - 1) / TILE_SIZE;
+		tileCountY = (viewportHeight + TILE_SIZE - 1) / TILE_SIZE;
+	}
+
+	void TiledLightCulling::cull(GLuint depthTexture, const Matrix4& projectionMatrix)
+	{
+		program->use();
+		program->setUniform("InverseProjectionMatrix", projectionMatrix.inversed());
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+		dispatch(tileCountX, tileCountY, 1);
+		program->unuse();
+	}
+
+	/* ClusteredLightCulling */
+	ClusteredLightCulling::ClusteredLightCulling(const Camera* camera, const LightBuffer* lights) : LightCulling("shaders/general/clusterCulling.comp", getShaderDefines(), camera, lights) {}
+
+	std::vector<std::string> ClusteredLightCulling::getShaderDefines()
+	{
+		return {
+			"CLUSTER_COUNT_X " + std::to_string(CLUSTER_COUNT_X),
+			"CLUSTER_COUNT_Y " + std::to_string(CLUSTER_COUNT_Y),
+			"CLUSTER_COUNT_Z " + std::to_string(CLUSTER_COUNT_Z),
+			"MAX_LIGHTS_PER_CLUSTER " + std::to_string(MAX_LIGHTS_PER_CLUSTER)
+		};
+	}
+
+	void ClusteredLightCulling::initialize(unsigned int windowWidth, unsigned int windowHeight)
+	{
+		// the grid covers the screen independent of its resolution
+		createCellBuffer(CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z, MAX_LIGHTS_PER_CLUSTER);
+	}
+
+	void ClusteredLightCulling::cull(const Matrix4& projectionMatrix)
+	{
+		// near and far plane of a perspective projection, m22 = (f + n) / (n - f) and m23 = 2fn / (n - f)
+		float m22 = projectionMatrix.data[10];
+		float m23 = projectionMatrix.data[14];
+		zNear = m23 / (m22 - 1.f);
+		zFar = m23 / (m22 + 1.f);
+
+		program->use();
+		program->setUniform("InverseProjectionMatrix", projectionMatrix.inversed());
+		updateShader(program);
+
+		dispatch(CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+		program->unuse();
+	}
+
+	void ClusteredLightCulling::updateShader(ShaderProgram* shaderProgram) const
+	{
+		shaderProgram->setUniform("clusterZNear", zNear);
+		shaderProgram->setUniform("clusterZFar", zFar);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "camera.h"
+#include "lightbuffer.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Sorts lights into screen space cells with a compute shader, the lighting passes then only evaluate the lights of their cell.
+	class LightCulling
+	{
+	public:
+		// shader storage binding point of the cell lists, fixed in the shaders, the lights are bound by LightBuffer
+		static const GLuint CELL_BUFFER_BP = 1;
+
+		virtual ~LightCulling();
+
+		virtual void initialize(unsigned int windowWidth, unsigned int windowHeight) = 0;
+		void deleteBufferData();
+
+		GLuint cellBuffer = 0;
+	protected:
+		LightCulling(const char* computeShaderFilename, const std::vector<std::string>& defines, const Camera* camera, const LightBuffer* lights);
+
+		// every cell stores its light count followed by its light indices
+		void createCellBuffer(unsigned int cellCount, unsigned int maxLightsPerCell);
+		void dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
+
+		ShaderProgram* program = nullptr;
+	private:
+		const LightBuffer* lights;
+	};
+
+	// 2D tiles bounded by the depth buffer, used by the deferred lighting pass
+	class TiledLightCulling : public LightCulling
+	{
+	public:
+		static const unsigned int TILE_SIZE = 16;
+		static const unsigned int MAX_LIGHTS_PER_TILE = 256;
+
+		TiledLightCulling(const Camera* camera, const LightBuffer* lights);
+
+		// allocates the tiles of targets this large, the viewport covers all of them until it is set
+		void initialize(unsigned int windowWidth, unsigned int windowHeight) override;
+		// only the tiles of the rendered viewport are culled and indexed, it must fit into the initialized size
+		void setViewportSize(unsigned int viewportWidth, unsigned int viewportHeight);
+		void cull(GLuint depthTexture, const Matrix4& projectionMatrix);
+
+		// defines the culling and lighting shaders are compiled with
+		static std::vector<std::string> getShaderDefines();
+
+		unsigned int tileCountX = 0, tileCountY = 0;
+	};
+
+	// 3D froxel grid with exponential depth slices, independent of the depth buffer, used by the forward+ path
+	class ClusteredLightCulling : public LightCulling
+	{
+	public:
+		static const unsigned int CLUSTER_COUNT_X = 16;
+		static const unsigned int CLUSTER_COUNT_Y = 9;
+		static const unsigned int CLUSTER_COUNT_Z = 24;
+		static const unsigned int MAX_LIGHTS_PER_CLUSTER = 256;
+
+		ClusteredLightCulling(const Camera* camera, const LightBuffer* lights);
+
+		void initialize(unsigned int windowWidth, unsigned int windowHeight) override;
+		void cull(const Matrix4& projectionMatrix);
+
+		// sets the depth slicing uniforms of a shader reading the clusters
+		void updateShader(ShaderProgram* shaderProgram) const;
+
+		// defines the culling and shading shaders are compiled with
+		static std::vector<std::string> getShaderDefines();
+	private:
+		float zNear = 0.1f, zFar = 100.f;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "lightvolumes.h"
+
+#include "meshfactory.h"
+
+namespace engine
+{
+	LightVolumes::LightVolumes(const Camera* camera, const LightBuffer* lights, const GBuffer* gbuffer) : lights(lights)
+	{
+		sphere = MeshFactory::createSphere(1);
+
+		stencilProgram = new ShaderProgram();
+		stencilProgram->init("shaders/general/lightVolume.vert", "shaders/general/depthOnly.frag");
+		stencilProgram->link();
+		stencilProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+
+		lightingProgram = new ShaderProgram();
+		lightingProgram->init("shaders/general/lightVolume.vert", "shaders/general/lightVolume.frag", gbuffer->getShaderDefines());
+		lightingProgram->link();
+		lightingProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+		gbuffer->updateShader(lightingProgram);
+	}
+
+	LightVolumes::~LightVolumes()
+	{
+		delete sphere;
+		delete stencilProgram;
+		delete lightingProgram;
+	}
+
+	void LightVolumes::draw(const Vector3& viewPos, const Matrix4& inverseViewProjection)
+	{
+		if (lights->empty()) return;
+		GLsizei lightCount = (GLsizei)lights->size();
+
+		// stencil pass, depth fail counting also works with the camera inside a volume:
+		// back faces behind the surface increment and front faces behind it decrement, leaving the number of volumes containing it
+		glClear(GL_STENCIL_BUFFER_BIT);
+		glEnable(GL_STENCIL_TEST);
+		glEnable(GL_DEPTH_TEST);
+		glStencilFunc(GL_ALWAYS, 0, 0xFF);
+		glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+		glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthMask(GL_FALSE);
+		glDisable(GL_CULL_FACE);
+		// volumes reaching past the far plane must not lose their back faces
+		glEnable(GL_DEPTH_CLAMP);
+
+		stencilProgram->use();
+		sphere->drawInstanced(lightCount);
+		stencilProgram->unuse();
+
+		// lighting pass on back faces without depth test, so volumes around the camera are still drawn,
+		// pixels covered by another light's volume only are rejected by the shader's radius check
+		glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_FRONT);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+
+		lightingProgram->use();
+		lightingProgram->setUniform("viewPos", viewPos);
+		lightingProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+		sphere->drawInstanced(lightCount);
+		lightingProgram->unuse();
+
+		glDisable(GL_BLEND);
+		glCullFace(GL_BACK);
+		glEnable(GL_DEPTH_TEST);
+		glDisable(GL_DEPTH_CLAMP);
+		glDepthMask(GL_TRUE);
+		glDisable(GL_STENCIL_TEST);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "camera.h"
+#include "geometrybuffer.h"
+#include "lightbuffer.h"
+#include "mesh.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Deferred direct lighting by rasterizing a bounding sphere per light, so every light only shades the pixels its radius reaches.
+	// All lights are drawn in two instanced draws: a stencil pass counting the volumes that contain the visible surface
+	// and a lighting pass restricted to pixels with a nonzero count, blending additively.
+	class LightVolumes
+	{
+	public:
+		// the lighting program decodes the current layout of gbuffer, create a new instance when it changes
+		LightVolumes(const Camera* camera, const LightBuffer* lights, const GBuffer* gbuffer);
+		~LightVolumes();
+
+		// expects the GBuffer textures on their units and a bound framebuffer whose depth stencil attachment holds the scene depth
+		void draw(const Vector3& viewPos, const Matrix4& inverseViewProjection);
+	private:
+		const LightBuffer* lights;
+		Mesh* sphere = nullptr;
+		ShaderProgram* stencilProgram = nullptr;
+		ShaderProgram* lightingProgram = nullptr;
+	};
+}
\ No newline at end of file
@@ -1,7 +1,25 @@
 #include <sstream>
+#include <algorithm>
+#include <functional>
 
 #include "engine.h"
 #include "skybox.h"
+#include "lightculling.h"
+#include "lightvolumes.h"
+#include "visibilitybuffer.h"
+#include "rendergraph.h"
+#include "screenviewport.h"
+#include "groundtruthao.h"
+#include "hizbuffer.h"
+#include "occlusionculling.h"
+#include "softwareocclusion.h"
+#include "tileclassification.h"
+#include "depthoffield.h"
+#include "shadervariantcache.h"
+#include "computeblur.h"
+#include "dynamicresolution.h"
+#include "passtimer.h"
+#include "qualitygovernor.h"
 
 using namespace engine;
 
@@ -15,33 +33,52 @@ class MyApp : public App
 	Camera* camera = new Camera(0);
 	bool catchCursor = false;
 	Vector2 lastCursorPos;
+	// GBuffer consumers reconstruct world positions from depth with this
+	Matrix4 inverseViewProjection;
 
 	Skybox* skybox = new Skybox(camera);
 
 	// for debugging
 	int selectedMaterial = 0;
 	TextureCubemap* environmentMap, *irradianceMap, *prefilterMap;
-
-	ShaderProgram* geoProgram;
-	ShaderProgram* lightProgram;
-	ShaderProgram* bloomSeparationProgram;
-	ShaderProgram* dofProgram;
-	ShaderProgram* horizontalBlurProgram;
-	ShaderProgram* vertikalBlurProgram;
-	ShaderProgram* bloomProgram;
-	ShaderProgram* reflectionsProgram;
-	ShaderProgram* fastBoxBlurProgram;
-	ShaderProgram* ssaoProgram;
-	ShaderProgram* reflectionBlendProgram;
-
+	TextureInfo* irradianceMapInfo, *prefilterMapInfo, *brdfLUTinfo;
+
+	// programs writing or reading the GBuffer, rebuilt when its layout changes
+	ShaderProgram* geoProgram = nullptr;
+	ShaderProgram* lightProgram = nullptr;
+	ShaderProgram* tiledLightProgram = nullptr;
+	ShaderProgram* ambientLightProgram = nullptr;
+	ShaderProgram* reflectionsProgram = nullptr;
+	ShaderProgram* hiZTraceProgram = nullptr;
+	ShaderProgram* reflectionResolveProgram = nullptr;
+	ShaderProgram* ssaoProgram = nullptr;
+	ShaderProgram* ssaoTemporalProgram = nullptr;
+	ShaderProgram* ssaoUpsampleProgram = nullptr;
+
+	ShaderProgram* depthPrepassProgram;
+	ShaderProgram* forwardProgram;
+	ShaderProgram* bloomDownsampleProgram;
+	ShaderProgram* bloomUpsampleProgram;
+	// separable blurs of the SSAO and reflection targets in compute shaders
+	ComputeBlur* computeBlur = nullptr;
+
+	// the final pass from the HDR image to the display, compiled for each combination of the effects it applies
+	enum CompositeFeature { COMPOSITE_REFLECTIONS = 1, COMPOSITE_DOF = 2, COMPOSITE_BLOOM = 4 };
+	ShaderVariantCache* compositePrograms = nullptr;
+
+	// bloom filters the bright part of the HDR image down a mip chain and back up, the levels set its radius
 	float bloomExposure = 0.2f;
 	bool useBloom = false;
-	int bloomBlur = 5;
-	float bloomThreshold = 0.2f;
+	int bloomLevels = 5;
+	float bloomRadius = 1.0f;
+	float bloomThreshold = 1.0f;
+	// bilinear filtering for the bloom chain's taps into targets sampled with nearest filtering elsewhere
+	GLuint linearSampler = 0;
 
+	// circle of confusion at half resolution, tile dilation and a fixed gather kernel at quarter resolution
 	bool useDOF = false;
 	float focalDepth = 2.0f;
-	int dofSamples = 25;
+	DepthOfField* depthOfField = nullptr;
 
 	bool useSsr = false;
 	bool useSsao = false;
@@ -51,24 +88,110 @@ class MyApp : public App
 	int stepIterations = 400;
 	float tolerance = 0.5f;
 
+	// reflections marched in fixed steps or traced through the hierarchical depth buffer, which skips empty space and
+	// can trace at half resolution, the hits are then resolved against the full resolution image
+	enum ReflectionTracing { LINEAR_MARCH, HIZ_TRACE };
+	int reflectionTracing = HIZ_TRACE;
+	HiZBuffer* hiZBuffer = nullptr;
+	int hiZIterations = 64;
+	bool halfResolutionReflections = false;
+
 	int ambientSamples = 32;
 	float ambientRadius = 0.5f;
 	float ambientBias = 0.025f;
 
+	// ambient occlusion from the hemisphere kernel of the SSAO pass or from horizons searched by GTAO compute passes
+	enum AmbientOcclusionMethod { HEMISPHERE_SSAO, GROUND_TRUTH_AO };
+	int ambientOcclusionMethod = HEMISPHERE_SSAO;
+	GroundTruthAO* groundTruthAO = nullptr;
+	int gtaoDirections = 2;
+	int gtaoSteps = 4;
+
+	// SSAO at full resolution with a box blur, or at half or quarter resolution with a few kernel samples per frame that
+	// are reprojected and accumulated over frames, then upsampled along depth and normal edges
+	enum SsaoResolution { SSAO_FULL, SSAO_HALF, SSAO_QUARTER };
+	int ssaoResolution = SSAO_HALF;
+	int ambientSamplesPerFrame = 8;
+	// the blur of full resolution SSAO, the bilateral one keeps the occlusion of a surface off the surfaces behind it
+	enum SsaoBlur { SSAO_BOX_BLUR, SSAO_GAUSSIAN_BLUR, SSAO_BILATERAL_BLUR };
+	int ssaoBlur = SSAO_BOX_BLUR;
+
+	// temporal anti-aliasing of the final image: the projection is jittered every frame and the reprojected history is
+	// blended with the new frame, so effects with few samples per frame converge over frames as well
+	bool useTaa = false;
+	float taaFeedback = 0.1f;
+	HistoryBuffer taaHistory{ GL_RGBA16F };
+	ShaderProgram* motionVectorProgram = nullptr;
+	ShaderProgram* taaProgram = nullptr;
+	// sample patterns that change between frames follow this counter
+	unsigned int frameIndex = 0;
+
+	// the scene is rendered into a scaled down viewport to hold a GPU time budget, then upscaled to the window along
+	// edges and sharpened, the interface stays at the window resolution
+	DynamicResolution* dynamicResolution = nullptr;
+	ShaderProgram* upscaleProgram = nullptr;
+	ShaderProgram* sharpenProgram = nullptr;
+	// in stops, 0 sharpens the most
+	float upscaleSharpness = 0.2f;
+
+	// GPU time of every render graph pass, the governor trades sample and iteration counts of the effects for it,
+	// settings exported to the file are loaded pinned at start
+	PassTimer* passTimer = nullptr;
+	QualityGovernor* qualityGovernor = nullptr;
+	const std::string qualitySettingsFile = "quality.cfg";
+
+	// screen tiles flagged by what the GBuffer holds, lighting, SSAO and reflections only draw the tiles they have work on
+	TileClassification* tileClassification = nullptr;
+
 	bool showGbufferContent = false;
+	int gbufferLayout = GBuffer::GB_LAYOUT_OCTAHEDRAL;
+
+	// how the deferred path evaluates direct light: every light per pixel, culled per screen tile or rasterized as light volumes
+	enum LightingMethod { UNCULLED_LIGHTS, TILED_LIGHTS, LIGHT_VOLUMES };
+	int lightingMethod = TILED_LIGHTS;
+	TiledLightCulling* tiledLightCulling = nullptr;
+	ClusteredLightCulling* clusteredLightCulling = nullptr;
+	LightVolumes* lightVolumes = nullptr;
+
+	// deferred shading through the GBuffer or clustered forward shading after a depth prepass
+	enum RenderPath { DEFERRED_RENDERING, FORWARD_PLUS_RENDERING };
+	int renderPath = DEFERRED_RENDERING;
+	// the deferred path can fill the GBuffer from a visibility buffer, shading each pixel's material once regardless of overdraw
+	bool useVisibilityBuffer = false;
+	VisibilityBuffer* visibilityBuffer = nullptr;
+	// lay down depth first so the GBuffer shader runs once per pixel, the forward path always does
+	bool useDepthPrepass = false;
+	// draws only what other objects do not hide, GBuffer pass only: on the GPU against the Hi-Z pyramid of last frame
+	// and of the first drawn objects, on the CPU against a few large occluders rasterized before drawing
+	enum OcclusionCullingMethod { NO_OCCLUSION_CULLING, GPU_OCCLUSION_CULLING, CPU_OCCLUSION_CULLING };
+	int occlusionCullingMethod = NO_OCCLUSION_CULLING;
+	OcclusionCulling* occlusionCulling = nullptr;
+	SoftwareOcclusion* softwareOcclusion = nullptr;
+
+	// samples passed by the shading geometry pass, read back without stalling once available, to show the overdraw
+	GLuint overdrawQuery = 0;
+	bool overdrawQueryPending = false;
+	GLuint64 shadedFragments = 0;
+	// GPU time of the ambient occlusion passes in nanoseconds, read back the same way
+	GLuint ambientOcclusionQuery = 0;
+	bool ambientOcclusionQueryPending = false;
+	bool measuringAmbientOcclusion = false;
+	GLuint64 ambientOcclusionTime = 0;
 
 	Model* models[6];
 	std::vector<Material*> allMaterials;
 
+	// screen sized targets are allocated in buckets, resizing the window mostly just renders a different viewport of them
+	ScreenViewport* screenViewport = new ScreenViewport(engine.windowWidth, engine.windowHeight);
 	GBuffer gbuffer;
 	ShadedBuffer shadedBuffer;
-	BloomBuffer bloomBuffer;
-	PingPongBuffer pingPongBuffer;
-	ReflectionsBuffer reflectionsBuffer;
-	BlurBuffer blurBuffer;
 	SsaoBuffer ssaoBuffer;
-	ReflectionsBlendBuffer reflectionsBlendBuffer;
-	std::vector<Light> lights;
+	// transient targets of the render graph passes, only effects in use hold textures
+	RenderTargetPool renderTargetPool;
+	std::vector<std::string> executedPasses;
+	unsigned int culledPasses = 0;
+	unsigned int targetReallocations = 0;
+	LightBuffer lights;
 
 	void updateProjection()
 	{
@@ -85,6 +208,26 @@ class MyApp : public App
 		delete sceneGraph;
 		delete quad;
 		delete skybox;
+		delete tiledLightCulling;
+		delete clusteredLightCulling;
+		delete lightVolumes;
+		delete visibilityBuffer;
+		delete groundTruthAO;
+		delete tileClassification;
+		delete hiZBuffer;
+		delete occlusionCulling;
+		delete softwareOcclusion;
+		delete computeBlur;
+		delete dynamicResolution;
+		delete qualityGovernor;
+		delete passTimer;
+		delete depthOfField;
+		delete compositePrograms;
+		delete screenViewport;
+		glDeleteSamplers(1, &linearSampler);
+		glDeleteQueries(1, &overdrawQuery);
+		glDeleteQueries(1, &ambientOcclusionQuery);
+		lights.deleteBufferData();
 		delete camera;
 	}
 
@@ -92,28 +235,54 @@ class MyApp : public App
 	{
 		engine.windowWidth = newWidth;
 		engine.windowHeight = newHeight;
+		// while the window fits into the targets only the viewport changes, they shrink once resizing settled
+		if (screenViewport->resize(newWidth, newHeight)) resizeRenderTargets();
+		applyRenderScale();
+		updateProjection();
+	}
+
+	// after the window size or the render scale changed the viewport
+	void applyRenderScale()
+	{
+		screenViewport->setScale(dynamicResolution->getScale());
+		// the histories cover the old viewport
+		ssaoBuffer.history.valid = false;
+		taaHistory.valid = false;
+		tiledLightCulling->setViewportSize(screenViewport->getWidth(), screenViewport->getHeight());
+		screenViewport->apply();
+	}
+
+	// reallocates every screen sized target at the current bucket size of the screen viewport
+	void resizeRenderTargets()
+	{
+		unsigned int width = screenViewport->getTargetWidth();
+		unsigned int height = screenViewport->getTargetHeight();
 		glActiveTexture(GL_TEXTURE0);
 		gbuffer.deleteBufferData();
-		gbuffer.initialize(newWidth, newHeight);
+		gbuffer.initialize(width, height);
+		visibilityBuffer->deleteBufferData();
+		visibilityBuffer->initialize(width, height);
+		groundTruthAO->deleteBufferData();
+		groundTruthAO->initialize(width, height);
+		tileClassification->deleteBufferData();
+		tileClassification->initialize(width, height);
+		hiZBuffer->deleteBufferData();
+		hiZBuffer->initialize(width, height);
+		occlusionCulling->deleteBufferData();
+		occlusionCulling->initialize(width, height);
 		glActiveTexture(GL_TEXTURE1);
 		shadedBuffer.deleteBufferData();
-		shadedBuffer.initialize(newWidth, newHeight);
-		glActiveTexture(GL_TEXTURE2);
-		bloomBuffer.deleteBufferData();
-		bloomBuffer.initialize(newWidth, newHeight);
-		glActiveTexture(GL_TEXTURE3);
-		pingPongBuffer.deleteBufferData();
-		pingPongBuffer.initialize(newWidth, newHeight);
-		reflectionsBuffer.deleteBufferData();
-		reflectionsBuffer.initialize(newWidth, newHeight);
-		blurBuffer.deleteBufferData();
-		blurBuffer.initialize(newWidth, newHeight);
+		shadedBuffer.initialize(width, height);
+		// reallocated at the SSAO resolution by the next frame using it
 		ssaoBuffer.deleteBufferData();
-		ssaoBuffer.initialize(newWidth, newHeight);
-		reflectionsBlendBuffer.deleteBufferData();
-		reflectionsBlendBuffer.initialize(newWidth, newHeight);
-		glViewport(0, 0, newWidth, newHeight);
-		updateProjection();
+		taaHistory.deleteBufferData();
+		renderTargetPool.clear();
+		tiledLightCulling->deleteBufferData();
+		tiledLightCulling->initialize(width, height);
+		tiledLightCulling->setViewportSize(screenViewport->getWidth(), screenViewport->getHeight());
+		clusteredLightCulling->deleteBufferData();
+		clusteredLightCulling->initialize(width, height);
+		targetReallocations++;
 	}
 
 	void keyCallback(int key, int scancode, int action, int mods) override
@@ -153,29 +322,33 @@ class MyApp : public App
 		SceneNode* root = sceneGraph->getRoot();
 		root->setDrawable(models[5]); // assign ground to root
 
+		// the ground and the trees hide the most, the alpha tested leaves are left out of the occluders
+		softwareOcclusion = new SoftwareOcclusion();
+		softwareOcclusion->addOccluder(root);
+
 		// behind camera, to the left
-		lights.push_back(Light(Vector3(-20, 4.f, 18.f), Vector3(1.f, 0.6f, 0.2f), 40.f));
+		lights.add(Light(Vector3(-20, 4.f, 18.f), Vector3(1.f, 0.6f, 0.2f), 40.f));
 
 		// three lights above water
-		lights.push_back(Light(Vector3(20, 2, 8.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(17, 2, 10.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(20, 2, 12.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(20, 2, 8.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(17, 2, 10.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(20, 2, 12.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
 
 		// randomly distributed
-		lights.push_back(Light(Vector3(20, 2, -22.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(-5, 2, -7.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(-10, 2, 17.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(0, 2, -16.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(9, 2, 2.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(-19, 2, 5.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(1, 2, 9.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
-		lights.push_back(Light(Vector3(16, 2, -12.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(20, 2, -22.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(-5, 2, -7.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(-10, 2, 17.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(0, 2, -16.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(9, 2, 2.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(-19, 2, 5.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(1, 2, 9.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
+		lights.add(Light(Vector3(16, 2, -12.f), Vector3(1.f, 0.6f, 0.2f), 15.f));
 
 		// in trees
-		lights.push_back(Light(Vector3(-12.4, 5.2, -19.8f), Vector3(1.f, 0.6f, 0.2f), 50.0));
-		lights.push_back(Light(Vector3(21.2, 3.6, 23.2), Vector3(1.f, 0.6f, 0.2f), 50.0));
-		lights.push_back(Light(Vector3(-22.6, 1.8, -2.6f), Vector3(1.f, 0.6f, 0.2f), 40.0));
-		lights.push_back(Light(Vector3(1.6, 3.8, 0.0), Vector3(1.f, 0.6f, 0.2f), 20.0));
+		lights.add(Light(Vector3(-12.4, 5.2, -19.8f), Vector3(1.f, 0.6f, 0.2f), 50.0));
+		lights.add(Light(Vector3(21.2, 3.6, 23.2), Vector3(1.f, 0.6f, 0.2f), 50.0));
+		lights.add(Light(Vector3(-22.6, 1.8, -2.6f), Vector3(1.f, 0.6f, 0.2f), 40.0));
+		lights.add(Light(Vector3(1.6, 3.8, 0.0), Vector3(1.f, 0.6f, 0.2f), 20.0));
 
 
 		const std::vector<Vector3> treeLocations = {
@@ -217,6 +390,7 @@ class MyApp : public App
 			SceneNode* tree = root->createNode();
 			tree->setDrawable(models[4]);
 			tree->setMatrix(Matrix4::CreateTranslation(treeLocations.at(i)) * Matrix4::CreateRotationY(i));
+			softwareOcclusion->addOccluder(tree);
 		}
 
 		SceneNode* lantern = root->createNode();
@@ -250,121 +424,276 @@ class MyApp : public App
 
 		irradianceMap = new TextureCubemap();
 		irradianceMap->convoluteIrradianceMapFromCubemap(skybox->getCubemap());
-		TextureInfo* irradianceMapInfo = new TextureInfo(GL_TEXTURE8, "irradianceMap", irradianceMap, nullptr);
+		irradianceMapInfo = new TextureInfo(GL_TEXTURE8, "irradianceMap", irradianceMap, nullptr);
 
 		prefilterMap = new TextureCubemap();
 		prefilterMap->convolutePrefilterMapFromCubemap(skybox->getCubemap());
-		TextureInfo* prefilterMapInfo = new TextureInfo(GL_TEXTURE9, "prefilterMap", prefilterMap, nullptr);
+		prefilterMapInfo = new TextureInfo(GL_TEXTURE9, "prefilterMap", prefilterMap, nullptr);
 
 		Texture2D* brdfLUT = new Texture2D();
 		brdfLUT->createBRDFLookupTexture();
-		TextureInfo* brdfLUTinfo = new TextureInfo(GL_TEXTURE10, "brdfLUT", brdfLUT, nullptr);
+		brdfLUTinfo = new TextureInfo(GL_TEXTURE10, "brdfLUT", brdfLUT, nullptr);
 		
-		gbuffer.initialize(engine.windowWidth, engine.windowHeight);
-		shadedBuffer.initialize(engine.windowWidth, engine.windowHeight);
-		bloomBuffer.initialize(engine.windowWidth, engine.windowHeight);
-		pingPongBuffer.initialize(engine.windowWidth, engine.windowHeight);
-		reflectionsBuffer.initialize(engine.windowWidth, engine.windowHeight);
-		reflectionsBlendBuffer.initialize(engine.windowWidth, engine.windowHeight);
-		blurBuffer.initialize(engine.windowWidth, engine.windowHeight);
-		ssaoBuffer.initialize(engine.windowWidth, engine.windowHeight);
+		gbuffer.layout = (GBuffer::GB_LAYOUT)gbufferLayout;
+		gbuffer.initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+		shadedBuffer.initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
 		ssaoBuffer.generateSampleKernel();
 		ssaoBuffer.generateNoiseTexture();
+		glGenQueries(1, &overdrawQuery);
+		glGenQueries(1, &ambientOcclusionQuery);
+
+		glGenSamplers(1, &linearSampler);
+		glSamplerParameteri(linearSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glSamplerParameteri(linearSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glSamplerParameteri(linearSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glSamplerParameteri(linearSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
 		try
 		{
-			geoProgram = new ShaderProgram();
-			geoProgram->init("shaders/general/GBUFFER.vert", "shaders/general/GBUFFER.frag");
-			geoProgram->link();
-			geoProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
-			sceneGraph->getRoot()->setShaderProgram(geoProgram);
-
-			lightProgram = new ShaderProgram();
-			lightProgram->init("shaders/general/quad2D.vert", "shaders/general/PBR.frag");
-			lightProgram->link();
-
-			lightProgram->use();
-			lightProgram->setUniform("gScreenSize", Vector2((float)engine.windowWidth, (float)engine.windowHeight));
-			lightProgram->setUniform("gPosition", GBuffer::GB_POSITION);
-			lightProgram->setUniform("gAlbedo", GBuffer::GB_ALBEDO);
-			lightProgram->setUniform("gNormal", GBuffer::GB_NORMAL);
-			lightProgram->setUniform("gMetallicRoughnessAO", GBuffer::GB_METALLIC_ROUGHNESS_AO);
-			lightProgram->setUniform("gSsao", GBuffer::GB_NUMBER_OF_TEXTURES);
-			irradianceMapInfo->updateShader(lightProgram);
-			prefilterMapInfo->updateShader(lightProgram);
-			brdfLUTinfo->updateShader(lightProgram);
-			lightProgram->unuse();
-
-			dofProgram = new ShaderProgram();
-			dofProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/DOF.frag");
-			dofProgram->link();
-			dofProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
-
-			dofProgram->use();
-			dofProgram->setUniform("gScreenSize", Vector2((float)engine.windowWidth, (float)engine.windowHeight));
-			dofProgram->setUniform("gPosiion", GBuffer::GB_POSITION);
-			dofProgram->setUniform("gNormal", 1);
-			dofProgram->setUniform("gBloom", 2);
-			dofProgram->unuse();
-
-			horizontalBlurProgram = new ShaderProgram();
-			horizontalBlurProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/blur_horizontal.frag");
-			horizontalBlurProgram->link();
-
-			vertikalBlurProgram = new ShaderProgram();
-			vertikalBlurProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/blur_vertikal.frag");
-			vertikalBlurProgram->link();
-
-			bloomSeparationProgram = new ShaderProgram();
-			bloomSeparationProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/bloom_separation.frag");
-			bloomSeparationProgram->link();
-			bloomSeparationProgram->use();
-			bloomSeparationProgram->setUniform("gShaded", 0);
-			bloomSeparationProgram->unuse();
-
-			bloomProgram = new ShaderProgram();
-			bloomProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/bloom_blend.frag");
-			bloomProgram->link();
-
-			reflectionsProgram = new ShaderProgram();
-			reflectionsProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/SSR.frag");
-			reflectionsProgram->link();
-			reflectionsProgram->use();
-			reflectionsProgram->setUniform("gPosition", 0);
-			reflectionsProgram->setUniform("gNormal", 1);
-			reflectionsProgram->setUniform("gShaded", 2);
-			reflectionsProgram->setUniform("gMetallicRoughnessAO", 3);
-			reflectionsProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
-			reflectionsProgram->unuse();
-
-			fastBoxBlurProgram = new ShaderProgram();
-			fastBoxBlurProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/blur_fastBox.frag");
-			fastBoxBlurProgram->link();
-			fastBoxBlurProgram->use();
-			fastBoxBlurProgram->setUniform("gShaded", 0);
-			fastBoxBlurProgram->unuse();
-
-			ssaoProgram = new ShaderProgram();
-			ssaoProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/SSAO.frag");
-			ssaoProgram->link();
-			ssaoProgram->use();
-			ssaoProgram->setUniform("gPosition", 0);
-			ssaoProgram->setUniform("gNormal", 1);
-			ssaoProgram->setUniform("texNoise", 2);
-			ssaoProgram->setUniform("gDepth", 3);
-			ssaoProgram->setUniform("samples", ssaoBuffer.ssaoKernel);
-			ssaoProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
-			ssaoProgram->unuse();
-			
-			reflectionBlendProgram = new ShaderProgram;
-			reflectionBlendProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/reflection_blend.frag");
-			reflectionBlendProgram->link();
-			reflectionBlendProgram->use();
-			reflectionBlendProgram->setUniform("gReflection", 0);
-			reflectionBlendProgram->setUniform("gReflectionBlur", 1);
-			reflectionBlendProgram->setUniform("gMetallicRoughnessAO", 2);
-			reflectionBlendProgram->setUniform("gShaded", 3);
-			reflectionBlendProgram->unuse();
+			tiledLightCulling = new TiledLightCulling(camera, &lights);
+			tiledLightCulling->initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+			tiledLightCulling->setViewportSize(screenViewport->getWidth(), screenViewport->getHeight());
+
+			clusteredLightCulling = new ClusteredLightCulling(camera, &lights);
+			clusteredLightCulling->initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+
+			hiZBuffer = new HiZBuffer(screenViewport);
+			hiZBuffer->initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+
+			occlusionCulling = new OcclusionCulling(screenViewport);
+			occlusionCulling->initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+
+			computeBlur = new ComputeBlur(screenViewport);
+
+			dynamicResolution = new DynamicResolution();
+
+			passTimer = new PassTimer();
+			createQualityGovernor();
+
+			createGBufferPrograms();
+
+			depthPrepassProgram = new ShaderProgram();
+			depthPrepassProgram->init("shaders/general/depthPrepass.vert", "shaders/general/depthPrepass.frag");
+			depthPrepassProgram->link();
+			depthPrepassProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+
+			forwardProgram = new ShaderProgram();
+			forwardProgram->init("shaders/general/GBUFFER.vert", "shaders/general/FORWARD.frag", ClusteredLightCulling::getShaderDefines());
+			forwardProgram->link();
+			forwardProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+
+			forwardProgram->use();
+			irradianceMapInfo->updateShader(forwardProgram);
+			prefilterMapInfo->updateShader(forwardProgram);
+			brdfLUTinfo->updateShader(forwardProgram);
+			forwardProgram->unuse();
+
+			bloomDownsampleProgram = new ShaderProgram();
+			bloomDownsampleProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/bloom_downsample.frag");
+			bloomDownsampleProgram->link();
+
+			bloomUpsampleProgram = new ShaderProgram();
+			bloomUpsampleProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/bloom_upsample.frag");
+			bloomUpsampleProgram->link();
+
+			motionVectorProgram = new ShaderProgram();
+			motionVectorProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/motionVectors.frag");
+			motionVectorProgram->link();
+			motionVectorProgram->use();
+			motionVectorProgram->setUniform("depthTexture", 0);
+			motionVectorProgram->unuse();
+
+			taaProgram = new ShaderProgram();
+			taaProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/taa.frag");
+			taaProgram->link();
+			taaProgram->use();
+			taaProgram->setUniform("gCurrent", 0);
+			taaProgram->setUniform("gHistory", 1);
+			taaProgram->setUniform("gMotion", 2);
+			taaProgram->setUniform("depthTexture", 3);
+			taaProgram->unuse();
+
+			upscaleProgram = new ShaderProgram();
+			upscaleProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/upscale.frag");
+			upscaleProgram->link();
+			upscaleProgram->use();
+			upscaleProgram->setUniform("source", 0);
+			upscaleProgram->unuse();
+
+			sharpenProgram = new ShaderProgram();
+			sharpenProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/sharpen.frag");
+			sharpenProgram->link();
+			sharpenProgram->use();
+			sharpenProgram->setUniform("source", 0);
+			sharpenProgram->unuse();
+		}
+		catch (Exception e)
+		{
+			std::cout << e.message << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// settings of the effects the governor may change, the lowest priority is lowered first
+	void createQualityGovernor()
+	{
+		qualityGovernor = new QualityGovernor();
+		qualityGovernor->add("bloomLevels", &bloomLevels, 2, 8, 1, 1, 8, 0, { "Bloom Downsample", "Bloom Upsample" });
+		qualityGovernor->add("ssaoSamples", &ambientSamples, 8, 64, 4, 1, 64, 1, { "SSAO" }, [this]() { return ssaoResolution == SSAO_FULL && !useTaa; });
+		qualityGovernor->add("ssaoSamplesPerFrame", &ambientSamplesPerFrame, 2, 16, 2, 1, 64, 1, { "SSAO" }, [this]() { return ssaoResolution != SSAO_FULL || useTaa; });
+		qualityGovernor->add("gtaoSteps", &gtaoSteps, 2, 8, 1, 1, 8, 1, { "GTAO" });
+		qualityGovernor->add("ssrIterations", &stepIterations, 100, 800, 50, 50, 800, 2, { "SSR" });
+		qualityGovernor->add("hiZIterations", &hiZIterations, 24, 256, 8, 8, 256, 2, { "SSR Trace" });
+		qualityGovernor->add("gtaoDirections", &gtaoDirections, 1, 4, 1, 1, 4, 2, { "GTAO" });
+		qualityGovernor->add("ssaoResolution", &ssaoResolution, SSAO_QUARTER, SSAO_HALF, 1, SSAO_FULL, SSAO_QUARTER, 3, { "SSAO", "SSAO Accumulate", "SSAO Upsample" }, [this]() { return ambientOcclusionMethod == HEMISPHERE_SSAO; });
+		if (qualityGovernor->load(qualitySettingsFile)) std::cout << "Quality settings loaded from " << qualitySettingsFile << std::endl;
+	}
+
+	// every program writing or reading the GBuffer, compiled for its current layout
+	void createGBufferPrograms()
+	{
+		for (ShaderProgram* program : { geoProgram, lightProgram, tiledLightProgram, ambientLightProgram, reflectionsProgram, hiZTraceProgram, reflectionResolveProgram, ssaoProgram, ssaoTemporalProgram, ssaoUpsampleProgram })
+		{
+			delete program;
+		}
+		delete lightVolumes;
+		delete visibilityBuffer;
+		delete groundTruthAO;
+		delete tileClassification;
+		delete depthOfField;
+		delete compositePrograms;
+
+		std::vector<std::string> gbufferDefines = gbuffer.getShaderDefines();
+		// passes drawing the classified tiles instead of a full screen quad
+		std::vector<std::string> tileDefines = TileClassification::getShaderDefines();
+		tileDefines.insert(tileDefines.end(), gbufferDefines.begin(), gbufferDefines.end());
+
+		geoProgram = new ShaderProgram();
+		geoProgram->init("shaders/general/GBUFFER.vert", "shaders/general/GBUFFER.frag", gbufferDefines);
+		geoProgram->link();
+		geoProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+		sceneGraph->getRoot()->setShaderProgram(geoProgram);
+
+		lightVolumes = new LightVolumes(camera, &lights, &gbuffer);
+
+		visibilityBuffer = new VisibilityBuffer(camera, &gbuffer);
+		visibilityBuffer->initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+
+		tileClassification = new TileClassification(&gbuffer, screenViewport);
+		tileClassification->initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+
+		groundTruthAO = new GroundTruthAO(camera, &gbuffer, screenViewport, tileClassification);
+		groundTruthAO->initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+
+		depthOfField = new DepthOfField(&gbuffer, screenViewport);
+
+		std::vector<std::string> tiledDefines = TiledLightCulling::getShaderDefines();
+		tiledDefines.insert(tiledDefines.end(), tileDefines.begin(), tileDefines.end());
+		std::vector<std::string> ambientDefines = tileDefines;
+		ambientDefines.push_back("LIGHT_VOLUMES");
+
+		lightProgram = new ShaderProgram();
+		lightProgram->init("shaders/general/tile.vert", "shaders/general/PBR.frag", tileDefines);
+		lightProgram->link();
+
+		tiledLightProgram = new ShaderProgram();
+		tiledLightProgram->init("shaders/general/tile.vert", "shaders/general/PBR.frag", tiledDefines);
+		tiledLightProgram->link();
+
+		ambientLightProgram = new ShaderProgram();
+		ambientLightProgram->init("shaders/general/tile.vert", "shaders/general/PBR.frag", ambientDefines);
+		ambientLightProgram->link();
+
+		for (ShaderProgram* program : { lightProgram, tiledLightProgram, ambientLightProgram })
+		{
+			gbuffer.updateShader(program);
+			program->use();
+			program->setUniform("gSsao", GBuffer::GB_DEPTH_UNIT + 1);
+			irradianceMapInfo->updateShader(program);
+			prefilterMapInfo->updateShader(program);
+			brdfLUTinfo->updateShader(program);
+			program->unuse();
+		}
+
+		// the remaining inputs of the post processing passes follow the GBuffer units
+		compositePrograms = new ShaderVariantCache("shaders/general/quad2D.vert", "shaders/postprocessing/composite.frag", { "REFLECTIONS", "DOF", "BLOOM" }, gbufferDefines,
+			[this](ShaderProgram* program)
+			{
+				gbuffer.updateShader(program);
+				program->use();
+				program->setUniform("gShaded", GBuffer::GB_DEPTH_UNIT + 1);
+				program->setUniform("gReflection", GBuffer::GB_DEPTH_UNIT + 2);
+				program->setUniform("gReflectionBlur", GBuffer::GB_DEPTH_UNIT + 3);
+				program->setUniform("gDof", GBuffer::GB_DEPTH_UNIT + 4);
+				program->setUniform("gBloom", GBuffer::GB_DEPTH_UNIT + 5);
+				program->unuse();
+			});
+
+		reflectionsProgram = new ShaderProgram();
+		reflectionsProgram->init("shaders/general/tile.vert", "shaders/postprocessing/SSR.frag", tileDefines);
+		reflectionsProgram->link();
+		gbuffer.updateShader(reflectionsProgram);
+		reflectionsProgram->use();
+		reflectionsProgram->setUniform("gShaded", GBuffer::GB_DEPTH_UNIT + 1);
+		reflectionsProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+		reflectionsProgram->unuse();
+
+		hiZTraceProgram = new ShaderProgram();
+		hiZTraceProgram->init("shaders/general/tile.vert", "shaders/postprocessing/ssr_hiz_trace.frag", tileDefines);
+		hiZTraceProgram->link();
+		gbuffer.updateShader(hiZTraceProgram);
+		hiZTraceProgram->use();
+		hiZTraceProgram->setUniform("hiZ", GBuffer::GB_DEPTH_UNIT + 1);
+		hiZTraceProgram->setUniform("hiZLevels", (int)HiZBuffer::LEVELS);
+		hiZTraceProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+		hiZTraceProgram->unuse();
+
+		reflectionResolveProgram = new ShaderProgram();
+		reflectionResolveProgram->init("shaders/general/tile.vert", "shaders/postprocessing/ssr_resolve.frag", tileDefines);
+		reflectionResolveProgram->link();
+		gbuffer.updateShader(reflectionResolveProgram);
+		reflectionResolveProgram->use();
+		reflectionResolveProgram->setUniform("gHits", GBuffer::GB_DEPTH_UNIT + 1);
+		reflectionResolveProgram->setUniform("gShaded", GBuffer::GB_DEPTH_UNIT + 2);
+		reflectionResolveProgram->unuse();
+
+		ssaoProgram = new ShaderProgram();
+		ssaoProgram->init("shaders/general/tile.vert", "shaders/postprocessing/SSAO.frag", tileDefines);
+		ssaoProgram->link();
+		gbuffer.updateShader(ssaoProgram);
+		ssaoProgram->use();
+		ssaoProgram->setUniform("texNoise", GBuffer::GB_DEPTH_UNIT + 1);
+		ssaoProgram->setUniform("samples", ssaoBuffer.ssaoKernel);
+		ssaoProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+		ssaoProgram->unuse();
+
+		ssaoTemporalProgram = new ShaderProgram();
+		ssaoTemporalProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/ssao_temporal.frag", gbufferDefines);
+		ssaoTemporalProgram->link();
+		gbuffer.updateShader(ssaoTemporalProgram);
+		ssaoTemporalProgram->use();
+		ssaoTemporalProgram->setUniform("gSsaoRaw", GBuffer::GB_DEPTH_UNIT + 1);
+		ssaoTemporalProgram->setUniform("gSsaoHistory", GBuffer::GB_DEPTH_UNIT + 2);
+		ssaoTemporalProgram->unuse();
+
+		ssaoUpsampleProgram = new ShaderProgram();
+		ssaoUpsampleProgram->init("shaders/general/quad2D.vert", "shaders/postprocessing/ssao_upsample.frag", gbufferDefines);
+		ssaoUpsampleProgram->link();
+		gbuffer.updateShader(ssaoUpsampleProgram);
+		ssaoUpsampleProgram->use();
+		ssaoUpsampleProgram->setUniform("gSsao", GBuffer::GB_DEPTH_UNIT + 1);
+		ssaoUpsampleProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+		ssaoUpsampleProgram->unuse();
+	}
+
+	void setGBufferLayout(GBuffer::GB_LAYOUT layout)
+	{
+		gbuffer.layout = layout;
+		gbuffer.deleteBufferData();
+		gbuffer.initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+		try
+		{
+			createGBufferPrograms();
 		}
 		catch (Exception e)
 		{
@@ -376,248 +705,979 @@ class MyApp : public App
 	void showGbuffer() {
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
+		GLsizei width = screenViewport->getWidth();
+		GLsizei height = screenViewport->getHeight();
 		GLsizei halfWidth = (GLsizei)(engine.windowWidth / 2.0f);
 		GLsizei halfHeight = (GLsizei)(engine.windowHeight / 2.0f);
 
-		gbuffer.setBufferToRead(GBuffer::GB_POSITION);
-		glBlitFramebuffer(0, 0, engine.windowWidth, engine.windowHeight, 0, 0, halfWidth, halfHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		// the bottom left quarter stays empty, positions are not stored anymore
+		// targets are shown as stored, octahedral normals and packed channels are not decoded
 
 		gbuffer.setBufferToRead(GBuffer::GB_ALBEDO);
-		glBlitFramebuffer(0, 0, engine.windowWidth, engine.windowHeight, 0, halfHeight, halfWidth, engine.windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBlitFramebuffer(0, 0, width, height, 0, halfHeight, halfWidth, engine.windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
 
-		gbuffer.setBufferToRead(GBuffer::GB_METALLIC_ROUGHNESS_AO);
-		glBlitFramebuffer(0, 0, engine.windowWidth, engine.windowHeight, halfWidth, halfHeight, engine.windowWidth, engine.windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		if (gbuffer.getLayout().formats[GBuffer::GB_METALLIC_ROUGHNESS_AO] != 0)
+		{
+			gbuffer.setBufferToRead(GBuffer::GB_METALLIC_ROUGHNESS_AO);
+			glBlitFramebuffer(0, 0, width, height, halfWidth, halfHeight, engine.windowWidth, engine.windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		}
 
 		gbuffer.setBufferToRead(GBuffer::GB_NORMAL);
-		glBlitFramebuffer(0, 0, engine.windowWidth, engine.windowHeight, halfWidth, 0, engine.windowWidth, halfHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBlitFramebuffer(0, 0, width, height, halfWidth, 0, engine.windowWidth, halfHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
 
 		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 	}
 
+	void geometryPass(const Matrix4& viewProjection)
+	{
+		if (useVisibilityBuffer)
+		{
+			visibilityBuffer->render(sceneGraph->getRoot());
+			return;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.fbo);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (occlusionCullingMethod == GPU_OCCLUSION_CULLING)
+		{
+			// the objects visible last frame, then the ones the depth they left does not hide. With the prepass both
+			// phases lay down their depth before either is shaded, so the GBuffer pass only shades the final surfaces
+			occlusionCulling->beginFrame(sceneGraph->getRoot(), viewProjection);
+			bool disoccludedCulled = false;
+			drawGeometry([&](ShaderProgram* program)
+			{
+				occlusionCulling->draw(OcclusionCulling::FIRST_PHASE, program);
+				if (!disoccludedCulled) occlusionCulling->cullDisoccluded(gbuffer.depthTexture);
+				disoccludedCulled = true;
+				occlusionCulling->draw(OcclusionCulling::SECOND_PHASE, program);
+			});
+			occlusionCulling->endFrame(gbuffer.depthTexture);
+		}
+		else if (occlusionCullingMethod == CPU_OCCLUSION_CULLING)
+		{
+			softwareOcclusion->cull(sceneGraph->getRoot(), viewProjection);
+			drawGeometry([&](ShaderProgram* program) { softwareOcclusion->draw(program); });
+		}
+		else
+		{
+			drawGeometry([&](ShaderProgram* program) { sceneGraph->draw(program); });
+		}
+	}
+
+	// draw(program override) is called for the prepass, if enabled, and then without override to fill the GBuffer,
+	// only the samples of the second call count as shaded fragments
+	void drawGeometry(const std::function<void(ShaderProgram*)>& draw)
+	{
+		if (useDepthPrepass)
+		{
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			draw(depthPrepassProgram);
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+			glDepthFunc(GL_EQUAL);
+			glDepthMask(GL_FALSE);
+		}
+		bool measuring = beginOverdrawQuery();
+		draw(nullptr);
+		if (measuring) glEndQuery(GL_SAMPLES_PASSED);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LEQUAL);
+	}
+
+	// the reduced resolution modes and full resolution under TAA take a different subset of the kernel and rotate the
+	// noise every frame
+	void ssaoPass(const Vector3& translation, GLuint fbo, bool temporal)
+	{
+		// sky tiles keep what the pass writes for the background, no occlusion and no depth
+		const GLfloat background[4] = { 1.f, 0.f, 0.f, 0.f };
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glClearBufferfv(GL_COLOR, 0, background);
+		gbuffer.bindTextures();
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 1);
+		glBindTexture(GL_TEXTURE_2D, ssaoBuffer.noiseTexture);
+
+		int kernelSize = temporal ? ambientSamplesPerFrame : ambientSamples;
+		int kernelStride = temporal ? std::max(64 / kernelSize, 1) : 1;
+		ssaoProgram->use();
+		ssaoProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+		ssaoProgram->setUniform("viewPos", translation);
+		ssaoProgram->setUniform("radius", ambientRadius);
+		ssaoProgram->setUniform("bias", ambientBias);
+		ssaoProgram->setUniform("kernelSize", kernelSize);
+		ssaoProgram->setUniform("kernelStride", kernelStride);
+		ssaoProgram->setUniform("kernelOffset", temporal ? (int)(frameIndex % kernelStride) : 0);
+		ssaoProgram->setUniform("noiseOffset", temporal ? Vector2((float)(frameIndex % 4), (float)(frameIndex / 4 % 4)) : Vector2(0.f, 0.f));
+		tileClassification->drawTiles(TileClassification::GEOMETRY_TILES);
+		ssaoProgram->unuse();
+	}
+
+	// blends this frame's occlusion into the reprojected history, then flips the history targets
+	void ssaoTemporalPass(GLuint rawTexture)
+	{
+		HistoryBuffer& history = ssaoBuffer.history;
+		glBindFramebuffer(GL_FRAMEBUFFER, history.getFbo());
+		gbuffer.bindTextures();
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 1);
+		glBindTexture(GL_TEXTURE_2D, rawTexture);
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 2);
+		glBindTexture(GL_TEXTURE_2D, history.getHistoryTexture());
+
+		ssaoTemporalProgram->use();
+		ssaoTemporalProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+		ssaoTemporalProgram->setUniform("PreviousViewProjectionMatrix", camera->getPreviousProjectionMatrix() * camera->getPreviousViewMatrix());
+		ssaoTemporalProgram->setUniform("historyValid", history.valid);
+		quad->draw();
+		ssaoTemporalProgram->unuse();
+
+		history.swap();
+	}
+
+	void ssaoUpsamplePass(GLuint lowTexture, GLuint fbo)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		gbuffer.bindTextures();
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 1);
+		glBindTexture(GL_TEXTURE_2D, lowTexture);
+
+		ssaoUpsampleProgram->use();
+		ssaoUpsampleProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+		quad->draw();
+		ssaoUpsampleProgram->unuse();
+	}
+
+	void hiZTracePass(const Vector3& translation, GLuint fbo)
+	{
+		// tiles without reflective pixels keep no hit
+		const GLfloat noHit[4] = { 0.f, 0.f, 0.f, 0.f };
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glClearBufferfv(GL_COLOR, 0, noHit);
+		gbuffer.bindTextures();
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 1);
+		glBindTexture(GL_TEXTURE_2D, hiZBuffer->texture);
+
+		hiZTraceProgram->use();
+		hiZTraceProgram->setUniform("viewPos", translation);
+		hiZTraceProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+		hiZTraceProgram->setUniform("maxRayDistance", maxRayDistance);
+		hiZTraceProgram->setUniform("maxIterations", hiZIterations);
+		hiZTraceProgram->setUniform("tolerance", tolerance);
+		tileClassification->drawTiles(TileClassification::REFLECTIVE_TILES);
+		hiZTraceProgram->unuse();
+	}
+
+	// reflected colors at full resolution from the hits of the trace
+	void reflectionResolvePass(GLuint hitTexture, GLuint shadedTexture, GLuint fbo)
+	{
+		// tiles without reflective pixels keep a reflection of no visibility
+		const GLfloat noReflection[4] = { 0.f, 0.f, 0.f, 0.f };
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glClearBufferfv(GL_COLOR, 0, noReflection);
+		gbuffer.bindTextures();
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 1);
+		glBindTexture(GL_TEXTURE_2D, hitTexture);
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 2);
+		glBindTexture(GL_TEXTURE_2D, shadedTexture);
+
+		reflectionResolveProgram->use();
+		tileClassification->drawTiles(TileClassification::REFLECTIVE_TILES);
+		reflectionResolveProgram->unuse();
+	}
+
+	// movement of every pixel since the last frame, from the depth of the shaded image and the camera of both frames
+	void motionVectorPass(GLuint fbo)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, shadedBuffer.depthTexture);
+
+		motionVectorProgram->use();
+		motionVectorProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+		motionVectorProgram->setUniform("PreviousViewProjectionMatrix", camera->getPreviousProjectionMatrix() * camera->getPreviousViewMatrix());
+		motionVectorProgram->setUniform("jitter", camera->getJitter());
+		quad->draw();
+		motionVectorProgram->unuse();
+	}
+
+	// blends the composited frame into the reprojected history, keeps the result as the next history and shows it
+	// unless it is upscaled first
+	void temporalAntiAliasingPass(GLuint compositedTexture, GLuint motionTexture, bool present)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, taaHistory.getFbo());
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, compositedTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, taaHistory.getHistoryTexture());
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, motionTexture);
+		glActiveTexture(GL_TEXTURE3);
+		glBindTexture(GL_TEXTURE_2D, shadedBuffer.depthTexture);
+
+		taaProgram->use();
+		taaProgram->setUniform("historyValid", taaHistory.valid);
+		taaProgram->setUniform("feedback", taaFeedback);
+		quad->draw();
+		taaProgram->unuse();
+
+		if (present)
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, taaHistory.getFbo());
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBlitFramebuffer(0, 0, screenViewport->getWidth(), screenViewport->getHeight(), 0, 0, screenViewport->getWidth(), screenViewport->getHeight(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		taaHistory.swap();
+	}
+
+	// fills the window from the rendered viewport of the final image, interpolating along its edges
+	void edgeAdaptiveUpscalePass(GLuint sourceTexture, GLuint fbo)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glViewport(0, 0, screenViewport->getOutputWidth(), screenViewport->getOutputHeight());
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, sourceTexture);
+
+		upscaleProgram->use();
+		quad->draw();
+		upscaleProgram->unuse();
+	}
+
+	// restores the detail the upscaled image lost and shows it
+	void contrastAdaptiveSharpenPass(GLuint upscaledTexture)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, screenViewport->getOutputWidth(), screenViewport->getOutputHeight());
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, upscaledTexture);
+
+		sharpenProgram->use();
+		sharpenProgram->setUniform("outputSize", Vector2((float)screenViewport->getOutputWidth(), (float)screenViewport->getOutputHeight()));
+		sharpenProgram->setUniform("sharpness", upscaleSharpness);
+		quad->draw();
+		sharpenProgram->unuse();
+		screenViewport->apply();
+	}
+
+	void deferredLightingPass(const Vector3& translation, GLuint ssaoTexture)
+	{
+		// sort lights into screen tiles
+		if (lightingMethod == TILED_LIGHTS)
+		{
+			tiledLightCulling->cull(gbuffer.depthTexture, camera->getProjectionMatrix());
+		}
+
+		// lighting pass
+		gbuffer.bindTextures();
+		glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 1);
+		glBindTexture(GL_TEXTURE_2D, ssaoTexture);
+
+		if (lightingMethod == LIGHT_VOLUMES)
+		{
+			lightVolumePass(translation);
+			return;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, shadedBuffer.fbo);
+		glClear(GL_COLOR_BUFFER_BIT);
+		fullscreenLightPass(translation);
+		
+		// copy depth buffer
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer.fbo);
+		glBlitFramebuffer(0, 0, screenViewport->getWidth(), screenViewport->getHeight(), 0, 0, screenViewport->getWidth(), screenViewport->getHeight(), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	}
+
+	// every pixel evaluates its lights in a single full screen pass
+	void fullscreenLightPass(const Vector3& translation)
+	{
+		ShaderProgram* activeLightProgram = lightingMethod == TILED_LIGHTS ? tiledLightProgram : lightProgram;
+		activeLightProgram->use();
+
+		// direct light sources
+		if (lightingMethod == TILED_LIGHTS)
+		{
+			activeLightProgram->setUniform("tileCountX", (int)tiledLightCulling->tileCountX);
+		}
+		else
+		{
+			activeLightProgram->setUniform("lightCount", (int)lights.size());
+		}
+		activeLightProgram->setUniform("viewPos", translation);
+		activeLightProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+		activeLightProgram->setUniform("useSsao", useSsao);
+		activeLightProgram->setUniform("bloomThreshold", bloomThreshold);
+		tileClassification->drawTiles(TileClassification::GEOMETRY_TILES);
+		activeLightProgram->unuse();
+	}
+
+	// ambient light in a full screen pass, then every light only shades the pixels inside its volume, accumulated in the
+	// HDR shaded image whose depth and stencil buffer the volumes are tested against
+	void lightVolumePass(const Vector3& translation)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, shadedBuffer.fbo);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer.fbo);
+		glBlitFramebuffer(0, 0, screenViewport->getWidth(), screenViewport->getHeight(), 0, 0, screenViewport->getWidth(), screenViewport->getHeight(), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+		glDisable(GL_DEPTH_TEST);
+		ambientLightProgram->use();
+		ambientLightProgram->setUniform("viewPos", translation);
+		ambientLightProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+		ambientLightProgram->setUniform("useSsao", useSsao);
+		tileClassification->drawTiles(TileClassification::GEOMETRY_TILES);
+		ambientLightProgram->unuse();
+
+		lightVolumes->draw(translation, inverseViewProjection);
+	}
+
+	void forwardLightingPass(const Vector3& translation)
+	{
+		clusteredLightCulling->cull(camera->getProjectionMatrix());
+
+		glBindFramebuffer(GL_FRAMEBUFFER, shadedBuffer.fbo);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// shading pass against the prepass depth
+		depthPrepass();
+		forwardProgram->use();
+		forwardProgram->setUniform("viewPos", translation);
+		forwardProgram->setUniform("bloomThreshold", bloomThreshold);
+		clusteredLightCulling->updateShader(forwardProgram);
+		bool measuring = beginOverdrawQuery();
+		sceneGraph->draw(forwardProgram);
+		if (measuring) glEndQuery(GL_SAMPLES_PASSED);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LEQUAL);
+	}
+
+	// fills the depth buffer of the bound framebuffer and leaves depth testing at GL_EQUAL without writes,
+	// so the following pass shades only the visible fragments, alpha tested ones included
+	void depthPrepass()
+	{
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		sceneGraph->draw(depthPrepassProgram);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	bool beginOverdrawQuery()
+	{
+		return beginQuery(GL_SAMPLES_PASSED, overdrawQuery, overdrawQueryPending, shadedFragments);
+	}
+
+	// spans the passes from the first to the last one producing the ambient occlusion
+	void beginAmbientOcclusionTimer()
+	{
+		measuringAmbientOcclusion = beginQuery(GL_TIME_ELAPSED, ambientOcclusionQuery, ambientOcclusionQueryPending, ambientOcclusionTime);
+	}
+
+	void endAmbientOcclusionTimer()
+	{
+		if (measuringAmbientOcclusion) glEndQuery(GL_TIME_ELAPSED);
+		measuringAmbientOcclusion = false;
+	}
+
+	// returns false while the previous result is still in flight, then nothing is measured this frame
+	bool beginQuery(GLenum target, GLuint query, bool& pending, GLuint64& result)
+	{
+		if (pending)
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) return false;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+		}
+		glBeginQuery(target, query);
+		pending = true;
+		return true;
+	}
+
 	void update(double elapsedSecs) override
 	{
+		if (screenViewport->update(elapsedSecs)) resizeRenderTargets();
+		// picks the render scale and the effect settings from the GPU time of earlier frames, against one budget: the
+		// scale spends and frees time first, the settings are raised only at full scale and lowered only at the minimum
+		dynamicResolution->budgetMs = qualityGovernor->budgetMs;
+		if (dynamicResolution->update()) applyRenderScale();
+		passTimer->update();
+		bool scaling = dynamicResolution->enabled;
+		float scale = dynamicResolution->getScale();
+		qualityGovernor->update(*passTimer, !scaling || scale <= dynamicResolution->minScale, !scaling || scale >= 1.f);
+
 		// update camera
 		Vector2 cursorPos = engine.getCursorPos();
 		Vector2 cursorDiff = cursorPos - lastCursorPos;
 		lastCursorPos = cursorPos;
 
 		if (!catchCursor) cursorDiff = Vector2(0.0, 0.0);
+		bool taa = useTaa && !showGbufferContent;
+		if (taa) camera->setJitter(frameIndex, screenViewport->getWidth(), screenViewport->getHeight());
+		else camera->clearJitter();
 		camera->update((float)elapsedSecs, cursorDiff);
 
 		Vector3 translation = camera->getPosition();
+		Matrix4 viewProjection = camera->getProjectionMatrix() * camera->getViewMatrix();
+		inverseViewProjection = viewProjection.inversed();
+
+		// upload lights that changed since their buffer region was last written
+		lights.update();
+
+		// the forward path has no GBuffer, effects that read from it are skipped
+		bool deferred = renderPath == DEFERRED_RENDERING;
+		bool ssr = useSsr && deferred;
+		bool ssao = useSsao && deferred;
+		bool gtao = ssao && ambientOcclusionMethod == GROUND_TRUTH_AO;
+		bool temporalSsao = ssao && !gtao && ssaoResolution != SSAO_FULL && !showGbufferContent;
+		// the lighting writes the bright part for bloom along with the shaded image, light volumes add up the lights
+		// one by one and leave thresholding the sum to the bloom downsampling
+		bool brightPass = useBloom && !(deferred && lightingMethod == LIGHT_VOLUMES);
+		// the culling pyramid only follows the depth while the GBuffer pass draws through it
+		if (occlusionCullingMethod != GPU_OCCLUSION_CULLING || !deferred || useVisibilityBuffer) occlusionCulling->invalidate();
+
+		// the history is kept at the SSAO resolution and only continues from the frame right before
+		unsigned int ssaoLevel = ssaoResolution == SSAO_QUARTER ? 2 : 1;
+		if (!temporalSsao)
+		{
+			ssaoBuffer.history.valid = false;
+		}
+		else if (ssaoBuffer.history.width != screenViewport->getTargetWidth() >> ssaoLevel || ssaoBuffer.history.height != screenViewport->getTargetHeight() >> ssaoLevel)
+		{
+			ssaoBuffer.deleteBufferData();
+			ssaoBuffer.initialize(screenViewport->getTargetWidth() >> ssaoLevel, screenViewport->getTargetHeight() >> ssaoLevel);
+		}
+		if (!taa)
+		{
+			taaHistory.valid = false;
+		}
+		else if (taaHistory.width != screenViewport->getTargetWidth() || taaHistory.height != screenViewport->getTargetHeight())
+		{
+			taaHistory.deleteBufferData();
+			taaHistory.initialize(screenViewport->getTargetWidth(), screenViewport->getTargetHeight());
+		}
 
-		// geometry pass
-		glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.fbo);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		sceneGraph->draw();
+		// every pass declares what it reads and writes, the graph culls passes without consumers, orders the rest
+		// and takes their transient targets from the pool, screen sized ones are rendered in the viewport of a bucket
+		RenderGraph graph(&renderTargetPool, passTimer);
+		RenderTargetDesc screenTarget;
+		screenTarget.width = screenViewport->getTargetWidth();
+		screenTarget.height = screenViewport->getTargetHeight();
+
+		RenderResource gbufferTargets = graph.importTarget("GBuffer", gbuffer.fbo, 0);
+		RenderResource shaded = graph.importTarget("Shaded", shadedBuffer.fbo, shadedBuffer.texture);
+		RenderResource bright = graph.importTarget("Bright", shadedBuffer.fbo, shadedBuffer.brightTexture);
+		RenderResource backbuffer = graph.importTarget("Backbuffer", 0, 0);
+		// a scaled down viewport is upscaled to the window as the last pass
+		bool upscale = screenViewport->getWidth() != screenViewport->getOutputWidth() || screenViewport->getHeight() != screenViewport->getOutputHeight();
+
+		{
+			RenderPassBuilder pass = graph.addPass("Geometry");
+			gbufferTargets = pass.write(gbufferTargets);
+			pass.setExecute([&](const RenderGraph&) { geometryPass(viewProjection); });
+		}
 
 		// debug view of geometry buffer
-		if (showGbufferContent)
+		if (showGbufferContent && deferred)
 		{
-			showGbuffer();
+			RenderPassBuilder pass = graph.addPass("GBuffer View");
+			pass.read(gbufferTargets);
+			backbuffer = pass.write(backbuffer);
+			pass.setExecute([&](const RenderGraph&) { showGbuffer(); });
 		}
 		else
 		{
-			// SSAO Pass
-			if (useSsao) {
-				glBindFramebuffer(GL_FRAMEBUFFER, ssaoBuffer.fbo);
-				glClear(GL_COLOR_BUFFER_BIT);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_POSITION]);
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_NORMAL]);
-				glActiveTexture(GL_TEXTURE2);
-				glBindTexture(GL_TEXTURE_2D, ssaoBuffer.noiseTexture);
-
-				ssaoProgram->use();
-				ssaoProgram->setUniform("viewPos", translation);
-				ssaoProgram->setUniform("radius", ambientRadius);
-				ssaoProgram->setUniform("bias", ambientBias);
-				ssaoProgram->setUniform("kernelSize", ambientSamples);
-				quad->draw();
-				ssaoProgram->unuse();
-
-				// Blur SSAO Image 
-				glBindFramebuffer(GL_FRAMEBUFFER, blurBuffer.fbo);
-				glClear(GL_COLOR_BUFFER_BIT);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, ssaoBuffer.texture);
-				fastBoxBlurProgram->use();
-				fastBoxBlurProgram->setUniform("kernelSize", 1);
-				fastBoxBlurProgram->setUniform("kernelSeparation", 1);
-				quad->draw();
-				fastBoxBlurProgram->unuse();
+			// tile lists of the passes reading the GBuffer, the forward path has no GBuffer to classify
+			RenderResource tiles = NO_RENDER_RESOURCE;
+			if (deferred)
+			{
+				tiles = graph.importTarget("Tiles", 0, tileClassification->flagsTexture);
+				RenderPassBuilder pass = graph.addPass("Tile Classification");
+				pass.read(gbufferTargets);
+				tiles = pass.write(tiles);
+				pass.setExecute([&](const RenderGraph&) { tileClassification->classify(); });
 			}
 
-			// lighting pass
-			glBindFramebuffer(GL_FRAMEBUFFER, shadedBuffer.fbo);
-			glClear(GL_COLOR_BUFFER_BIT);
-			for (unsigned int i = 0; i < GBuffer::GB_NUMBER_OF_TEXTURES; i++) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_POSITION + i]);
+			RenderResource ambientOcclusion = NO_RENDER_RESOURCE;
+			if (gtao)
+			{
+				RenderResource depthPyramid = graph.importTarget("GTAO Depth Pyramid", 0, groundTruthAO->depthPyramid);
+				RenderPassBuilder depthPass = graph.addPass("GTAO Depth");
+				depthPass.read(gbufferTargets);
+				depthPyramid = depthPass.write(depthPyramid);
+				depthPass.setExecute([&](const RenderGraph&)
+				{
+					beginAmbientOcclusionTimer();
+					groundTruthAO->buildDepthPyramid(camera->getProjectionMatrix());
+				});
+
+				RenderTargetDesc horizonTarget = screenTarget;
+				horizonTarget.format = GL_RG16F;
+				RenderPassBuilder horizonPass = graph.addPass("GTAO");
+				horizonPass.read(gbufferTargets);
+				horizonPass.read(depthPyramid);
+				horizonPass.read(tiles);
+				RenderResource horizons = horizonPass.create("GTAO Raw", horizonTarget);
+				horizonPass.setExecute([&, horizons](const RenderGraph& graph)
+				{
+					groundTruthAO->sliceCount = gtaoDirections;
+					groundTruthAO->stepCount = gtaoSteps;
+					groundTruthAO->radius = ambientRadius;
+					groundTruthAO->computeOcclusion(graph.getTexture(horizons));
+				});
+
+				RenderTargetDesc ssaoTarget = screenTarget;
+				ssaoTarget.format = GL_R8;
+				RenderPassBuilder denoisePass = graph.addPass("GTAO Denoise");
+				denoisePass.read(horizons);
+				ambientOcclusion = denoisePass.create("SSAO", ssaoTarget);
+				denoisePass.setExecute([&, horizons, ambientOcclusion](const RenderGraph& graph)
+				{
+					groundTruthAO->denoise(graph.getTexture(horizons), graph.getTexture(ambientOcclusion));
+					endAmbientOcclusionTimer();
+				});
 			}
-			glActiveTexture(GL_TEXTURE0 + GBuffer::GB_NUMBER_OF_TEXTURES);
-			glBindTexture(GL_TEXTURE_2D, blurBuffer.texture);
-			
-			// draw objects
-			lightProgram->use();
-			lightProgram->setUniform("lightCount", (int) lights.size());
-			
-			// direct light sources
-			std::vector<Vector3> lightPositions;
-			std::vector<Vector3> lightColors;
-			for (int i = 0; i < lights.size(); i++)
+			else if (temporalSsao)
 			{
-				lightPositions.push_back(lights[i].position);
-				lightColors.push_back(lights[i].color * lights[i].brightness);
+				RenderTargetDesc rawTarget;
+				rawTarget.width = ssaoBuffer.history.width;
+				rawTarget.height = ssaoBuffer.history.height;
+				rawTarget.format = GL_RG16F;
+
+				RenderPassBuilder ssaoPassBuilder = graph.addPass("SSAO");
+				ssaoPassBuilder.read(gbufferTargets);
+				ssaoPassBuilder.read(tiles);
+				RenderResource ssaoRaw = ssaoPassBuilder.create("SSAO Raw", rawTarget);
+				ssaoPassBuilder.setExecute([&, ssaoRaw](const RenderGraph& graph)
+				{
+					beginAmbientOcclusionTimer();
+					screenViewport->apply(ssaoLevel);
+					ssaoPass(translation, graph.getFramebuffer(ssaoRaw), true);
+					screenViewport->apply();
+				});
+
+				RenderResource history = graph.importTarget("SSAO History", ssaoBuffer.history.getHistoryFbo(), ssaoBuffer.history.getHistoryTexture());
+				RenderResource accumulated = graph.importTarget("SSAO Accumulated", ssaoBuffer.history.getFbo(), ssaoBuffer.history.getTexture());
+				RenderPassBuilder temporalPass = graph.addPass("SSAO Accumulate");
+				temporalPass.read(gbufferTargets);
+				temporalPass.read(ssaoRaw);
+				temporalPass.read(history);
+				accumulated = temporalPass.write(accumulated);
+				temporalPass.setExecute([&, ssaoRaw](const RenderGraph& graph)
+				{
+					screenViewport->apply(ssaoLevel);
+					ssaoTemporalPass(graph.getTexture(ssaoRaw));
+					screenViewport->apply();
+				});
+
+				RenderTargetDesc ssaoTarget = screenTarget;
+				ssaoTarget.format = GL_R8;
+				RenderPassBuilder upsamplePass = graph.addPass("SSAO Upsample");
+				upsamplePass.read(gbufferTargets);
+				upsamplePass.read(accumulated);
+				ambientOcclusion = upsamplePass.create("SSAO", ssaoTarget);
+				upsamplePass.setExecute([&, accumulated, ambientOcclusion](const RenderGraph& graph)
+				{
+					ssaoUpsamplePass(graph.getTexture(accumulated), graph.getFramebuffer(ambientOcclusion));
+					endAmbientOcclusionTimer();
+				});
 			}
-			lightProgram->setUniform("lightPositions", lightPositions);
-			lightProgram->setUniform("lightColors", lightColors);
-			lightProgram->setUniform("viewPos", translation);
-			lightProgram->setUniform("useSsao", useSsao);
-			quad->draw();
-			lightProgram->unuse();
-			
-			// copy depth buffer
-			glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer.fbo);
-			glBlitFramebuffer(0, 0, engine.windowWidth, engine.windowHeight, 0, 0, engine.windowWidth, engine.windowHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-			
+			else if (ssao)
+			{
+				RenderPassBuilder ssaoPassBuilder = graph.addPass("SSAO");
+				ssaoPassBuilder.read(gbufferTargets);
+				ssaoPassBuilder.read(tiles);
+				RenderResource ssaoRaw = ssaoPassBuilder.create("SSAO Raw", screenTarget);
+				ssaoPassBuilder.setExecute([&, ssaoRaw, taa](const RenderGraph& graph)
+				{
+					beginAmbientOcclusionTimer();
+					// TAA averages the changing samples of full resolution SSAO
+					ssaoPass(translation, graph.getFramebuffer(ssaoRaw), taa);
+				});
+
+				// Blur SSAO Image
+				RenderPassBuilder blurPass = graph.addPass("SSAO Blur");
+				blurPass.read(ssaoRaw);
+				if (ssaoBlur == SSAO_BILATERAL_BLUR) blurPass.read(gbufferTargets);
+				RenderResource horizontal = blurPass.create("SSAO Blur Horizontal", screenTarget);
+				ambientOcclusion = blurPass.create("SSAO", screenTarget);
+				blurPass.setExecute([&, ssaoRaw, horizontal, ambientOcclusion, screenTarget](const RenderGraph& graph)
+				{
+					GLuint source = graph.getTexture(ssaoRaw);
+					GLuint intermediate = graph.getTexture(horizontal);
+					GLuint destination = graph.getTexture(ambientOcclusion);
+					if (ssaoBlur == SSAO_GAUSSIAN_BLUR) computeBlur->gaussian(source, intermediate, destination, screenTarget.format, 1.0f);
+					else if (ssaoBlur == SSAO_BILATERAL_BLUR) computeBlur->bilateral(source, intermediate, destination, screenTarget.format, 1.0f, gbuffer.depthTexture, camera->getProjectionMatrix());
+					else computeBlur->box(source, intermediate, destination, screenTarget.format, 1);
+					endAmbientOcclusionTimer();
+				});
+			}
+
+			{
+				RenderPassBuilder pass = graph.addPass("Lighting");
+				if (deferred)
+				{
+					pass.read(gbufferTargets);
+					pass.read(tiles);
+					if (ssao) pass.read(ambientOcclusion);
+				}
+				shaded = pass.write(shaded);
+				if (brightPass) bright = pass.write(bright);
+
+				pass.setExecute([&, ambientOcclusion](const RenderGraph& graph)
+				{
+					shadedBuffer.setBrightPass(brightPass);
+					if (deferred)
+					{
+						GLuint ssaoTexture = ssao ? graph.getTexture(ambientOcclusion) : 0;
+						deferredLightingPass(translation, ssaoTexture);
+					}
+					else
+					{
+						forwardLightingPass(translation);
+					}
+				});
+			}
+
 			// draw Skybox
-			skybox->draw();
-			
+			{
+				RenderPassBuilder pass = graph.addPass("Skybox");
+				shaded = pass.write(shaded);
+				if (brightPass) bright = pass.write(bright);
+				pass.setExecute([&](const RenderGraph&)
+				{
+					glBindFramebuffer(GL_FRAMEBUFFER, shadedBuffer.fbo);
+					skybox->setBloomThreshold(bloomThreshold);
+					skybox->draw();
+				});
+			}
+
+			// the frame stays linear HDR until the composite tone maps it, the effects only prepare inputs of the composite
+			RenderTargetDesc hdrTarget = screenTarget;
+			hdrTarget.format = GL_RGBA16F;
+
 			// Calculate Screen Space Reflections
-			if (useSsr) {
-				glBindFramebuffer(GL_FRAMEBUFFER, reflectionsBuffer.fbo);
-				glClear(GL_COLOR_BUFFER_BIT);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_POSITION]);
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_NORMAL]);
-				glActiveTexture(GL_TEXTURE2);
-				glBindTexture(GL_TEXTURE_2D, shadedBuffer.texture);
-				glActiveTexture(GL_TEXTURE3);
-				glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_METALLIC_ROUGHNESS_AO]);
-
-				reflectionsProgram->use();
-				reflectionsProgram->setUniform("gScreenSize", Vector2((float)engine.windowWidth, (float)engine.windowHeight));
-				reflectionsProgram->setUniform("viewPos", translation);
-
-				reflectionsProgram->setUniform("maxRayDistance", maxRayDistance);
-				reflectionsProgram->setUniform("stepResolution", stepResolution);
-				reflectionsProgram->setUniform("stepIterations", stepIterations);
-				reflectionsProgram->setUniform("tolerance", tolerance);
-				quad->draw();
-				reflectionsProgram->unuse();
-
-				// Blur Shaded Image (for rough reflections)
-				glBindFramebuffer(GL_FRAMEBUFFER,blurBuffer.fbo);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, reflectionsBuffer.texture);
-				fastBoxBlurProgram->use();
-				fastBoxBlurProgram->setUniform("kernelSize", 3);
-				fastBoxBlurProgram->setUniform("kernelSeparation", 2);
-				quad->draw();
-				fastBoxBlurProgram->unuse();
-
-				glBindFramebuffer(GL_FRAMEBUFFER, reflectionsBlendBuffer.fbo);
-				glClear(GL_COLOR_BUFFER_BIT);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, reflectionsBuffer.texture);
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, blurBuffer.texture);
-				glActiveTexture(GL_TEXTURE2);
-				glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_METALLIC_ROUGHNESS_AO]);
-				glActiveTexture(GL_TEXTURE3);
-				glBindTexture(GL_TEXTURE_2D, shadedBuffer.texture);
-				reflectionBlendProgram->use();
-				quad->draw();
-				reflectionBlendProgram->unuse();
+			RenderResource reflections = NO_RENDER_RESOURCE;
+			RenderResource reflectionsBlurred = NO_RENDER_RESOURCE;
+			if (ssr && reflectionTracing == HIZ_TRACE)
+			{
+				RenderResource hiZ = graph.importTarget("Hi-Z", 0, hiZBuffer->texture);
+				RenderPassBuilder hiZPass = graph.addPass("Hi-Z");
+				hiZPass.read(gbufferTargets);
+				hiZ = hiZPass.write(hiZ);
+				hiZPass.setExecute([&](const RenderGraph&) { hiZBuffer->build(gbuffer.depthTexture); });
+
+				unsigned int traceLevel = halfResolutionReflections ? 1 : 0;
+				RenderTargetDesc hitTarget;
+				hitTarget.width = screenTarget.width >> traceLevel;
+				hitTarget.height = screenTarget.height >> traceLevel;
+				hitTarget.format = GL_RGBA32F;
+				RenderPassBuilder tracePass = graph.addPass("SSR Trace");
+				tracePass.read(gbufferTargets);
+				tracePass.read(hiZ);
+				tracePass.read(tiles);
+				RenderResource hits = tracePass.create("Reflection Hits", hitTarget);
+				tracePass.setExecute([&, hits, traceLevel](const RenderGraph& graph)
+				{
+					screenViewport->apply(traceLevel);
+					hiZTracePass(translation, graph.getFramebuffer(hits));
+					screenViewport->apply();
+				});
+
+				RenderPassBuilder resolvePass = graph.addPass("SSR Resolve");
+				resolvePass.read(gbufferTargets);
+				resolvePass.read(hits);
+				resolvePass.read(shaded);
+				resolvePass.read(tiles);
+				reflections = resolvePass.create("Reflections", hdrTarget);
+				resolvePass.setExecute([&, hits, shaded, reflections](const RenderGraph& graph)
+				{
+					reflectionResolvePass(graph.getTexture(hits), graph.getTexture(shaded), graph.getFramebuffer(reflections));
+				});
+			}
+			else if (ssr)
+			{
+				RenderPassBuilder reflectionPass = graph.addPass("SSR");
+				reflectionPass.read(gbufferTargets);
+				reflectionPass.read(shaded);
+				reflectionPass.read(tiles);
+				reflections = reflectionPass.create("Reflections", hdrTarget);
+				reflectionPass.setExecute([&, shaded, reflections](const RenderGraph& graph)
+				{
+					// tiles without reflective pixels keep a reflection of no visibility
+					const GLfloat noReflection[4] = { 0.f, 0.f, 0.f, 0.f };
+					glBindFramebuffer(GL_FRAMEBUFFER, graph.getFramebuffer(reflections));
+					glClearBufferfv(GL_COLOR, 0, noReflection);
+					gbuffer.bindTextures();
+					glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 1);
+					glBindTexture(GL_TEXTURE_2D, graph.getTexture(shaded));
+
+					reflectionsProgram->use();
+					reflectionsProgram->setUniform("viewPos", translation);
+					reflectionsProgram->setUniform("InverseViewProjectionMatrix", inverseViewProjection);
+
+					reflectionsProgram->setUniform("maxRayDistance", maxRayDistance);
+					reflectionsProgram->setUniform("stepResolution", stepResolution);
+					reflectionsProgram->setUniform("stepIterations", stepIterations);
+					reflectionsProgram->setUniform("tolerance", tolerance);
+					tileClassification->drawTiles(TileClassification::REFLECTIVE_TILES);
+					reflectionsProgram->unuse();
+				});
 			}
 
-			//separate bright regions of shaded image and save into Pong FBO
-			if (useBloom) {
-				glBindFramebuffer(GL_FRAMEBUFFER, pingPongBuffer.fbo[1]);
-				glClear(GL_COLOR_BUFFER_BIT);
-				glActiveTexture(GL_TEXTURE0);
-				
-				glBindTexture(GL_TEXTURE_2D, useSsr ? reflectionsBlendBuffer.texture : shadedBuffer.texture);
-				bloomSeparationProgram->use();
-				bloomSeparationProgram->setUniform("bloomThreshold", bloomThreshold);
-				quad->draw();
-				bloomSeparationProgram->unuse();
-				
-				// bloom: apply blur to bright regions
-				bool firstBlurIteration = true;
-				for (int i = 0; i < bloomBlur; i++) {
-				
-					// horizontal blur kernel: Read from Pong Texture, Write into Ping FBO (Texture)
-					glBindFramebuffer(GL_FRAMEBUFFER, pingPongBuffer.fbo[0]);
-					glClear(GL_COLOR_BUFFER_BIT);
-					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, pingPongBuffer.texture[1]);
-					horizontalBlurProgram->use();
-					quad->draw();
-					horizontalBlurProgram->unuse();
-				
-					// vertikal blur kernel: Read from Ping Texture, Write into Pong FBO (Texture)
-					glBindFramebuffer(GL_FRAMEBUFFER, pingPongBuffer.fbo[1]);
-					glClear(GL_COLOR_BUFFER_BIT);
+			if (ssr)
+			{
+				// Blur reflections (for rough reflections)
+				RenderPassBuilder blurPass = graph.addPass("SSR Blur");
+				blurPass.read(reflections);
+				RenderResource horizontal = blurPass.create("Reflections Blur Horizontal", hdrTarget);
+				reflectionsBlurred = blurPass.create("Reflections Blurred", hdrTarget);
+				blurPass.setExecute([&, reflections, horizontal, reflectionsBlurred](const RenderGraph& graph)
+				{
+					// 7x7 taps two pixels apart
+					computeBlur->box(graph.getTexture(reflections), graph.getTexture(horizontal), graph.getTexture(reflectionsBlurred), GL_RGBA16F, 3, 2);
+				});
+			}
+
+			RenderResource bloom = NO_RENDER_RESOURCE;
+			if (useBloom)
+			{
+				// bright part of the image filtered down a chain of half sized HDR levels and back up, every level
+				// widens the blur while the cost stays about that of two full screen passes
+				RenderResource bloomSource = brightPass ? bright : shaded;
+				std::vector<RenderResource> levels;
+				RenderPassBuilder downsamplePass = graph.addPass("Bloom Downsample");
+				downsamplePass.read(bloomSource);
+				for (int i = 0; i < bloomLevels; i++)
+				{
+					RenderTargetDesc levelTarget;
+					levelTarget.width = screenTarget.width >> (i + 1);
+					levelTarget.height = screenTarget.height >> (i + 1);
+					levelTarget.format = GL_R11F_G11F_B10F;
+					levelTarget.filter = GL_LINEAR;
+					levels.push_back(downsamplePass.create("Bloom Level " + std::to_string(i + 1), levelTarget));
+				}
+				downsamplePass.setExecute([&, bloomSource, levels](const RenderGraph& graph)
+				{
 					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, pingPongBuffer.texture[0]);
-					vertikalBlurProgram->use();
-					quad->draw();
-					vertikalBlurProgram->unuse();
+					glBindSampler(0, linearSampler);
+					bloomDownsampleProgram->use();
+					bloomDownsampleProgram->setUniform("bloomThreshold", bloomThreshold);
+					bloomDownsampleProgram->setUniform("threshold", !brightPass);
+					for (unsigned int i = 0; i < levels.size(); i++)
+					{
+						// the first level reads the bright part of the image, the others halve the previous level
+						glBindFramebuffer(GL_FRAMEBUFFER, graph.getFramebuffer(levels[i]));
+						glBindTexture(GL_TEXTURE_2D, graph.getTexture(i == 0 ? bloomSource : levels[i - 1]));
+						screenViewport->apply(i + 1);
+						const RenderTargetDesc& desc = graph.getDesc(levels[i]);
+						bloomDownsampleProgram->setUniform("texelSize", Vector2(1.f / desc.width, 1.f / desc.height));
+						bloomDownsampleProgram->setUniform("firstLevel", i == 0);
+						quad->draw();
+					}
+					bloomDownsampleProgram->unuse();
+					glBindSampler(0, 0);
+					screenViewport->apply();
+				});
+
+				// every level is added onto the next larger one with a tent filter, the largest ends up with all of them
+				if (levels.size() > 1)
+				{
+					RenderPassBuilder upsamplePass = graph.addPass("Bloom Upsample");
+					upsamplePass.read(levels.back());
+					for (unsigned int i = 0; i + 1 < levels.size(); i++)
+					{
+						levels[i] = upsamplePass.write(levels[i]);
+					}
+					upsamplePass.setExecute([&, levels](const RenderGraph& graph)
+					{
+						glEnable(GL_BLEND);
+						glBlendFunc(GL_ONE, GL_ONE);
+						glActiveTexture(GL_TEXTURE0);
+						bloomUpsampleProgram->use();
+						bloomUpsampleProgram->setUniform("radius", bloomRadius);
+						for (unsigned int i = (unsigned int)levels.size() - 1; i > 0; i--)
+						{
+							glBindFramebuffer(GL_FRAMEBUFFER, graph.getFramebuffer(levels[i - 1]));
+							glBindTexture(GL_TEXTURE_2D, graph.getTexture(levels[i]));
+							screenViewport->apply(i);
+							const RenderTargetDesc& desc = graph.getDesc(levels[i - 1]);
+							bloomUpsampleProgram->setUniform("texelSize", Vector2(1.f / desc.width, 1.f / desc.height));
+							quad->draw();
+						}
+						bloomUpsampleProgram->unuse();
+						glDisable(GL_BLEND);
+						screenViewport->apply();
+					});
 				}
 
-				// add blurred regions (currently in Pong FBO) to original image and save result in Bloom FBO
-				glBindFramebuffer(GL_FRAMEBUFFER, bloomBuffer.fbo);
-				glClear(GL_COLOR_BUFFER_BIT);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, useSsr ? reflectionsBlendBuffer.texture : shadedBuffer.texture);
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, pingPongBuffer.texture[1]);
-				bloomProgram->use();
-				bloomProgram->setUniform("exposure", bloomExposure);
-				quad->draw();
-				bloomProgram->unuse();
+				// the composite adds the largest level to the image
+				bloom = levels[0];
 			}
-			
-			// DOF 
-			dofProgram->use();
-			dofProgram->setUniform("useDOF", useDOF);
-			dofProgram->setUniform("viewPos", translation);
-			dofProgram->setUniform("focalDepth", focalDepth);
-			dofProgram->setUniform("dofSamples", dofSamples);
-			
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			glClear(GL_COLOR_BUFFER_BIT);
-			
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_POSITION]);
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, gbuffer.texture[GBuffer::GB_NORMAL]);
-			glActiveTexture(GL_TEXTURE2);
-
-			if (useBloom) {
-				glBindTexture(GL_TEXTURE_2D, bloomBuffer.texture);
+
+			// blur of the depth of field at reduced resolution, its cost does not depend on the blur size
+			bool dof = useDOF && deferred;
+			RenderResource dofBlur = NO_RENDER_RESOURCE;
+			if (dof)
+			{
+				RenderTargetDesc prefilterTarget;
+				prefilterTarget.width = screenTarget.width / 2;
+				prefilterTarget.height = screenTarget.height / 2;
+				prefilterTarget.format = GL_RGBA16F;
+				prefilterTarget.filter = GL_LINEAR;
+				RenderPassBuilder prefilterPass = graph.addPass("DOF Prefilter");
+				prefilterPass.read(gbufferTargets);
+				prefilterPass.read(shaded);
+				if (ssr)
+				{
+					prefilterPass.read(reflections);
+					prefilterPass.read(reflectionsBlurred);
+				}
+				RenderResource prefiltered = prefilterPass.create("DOF Half Resolution", prefilterTarget);
+				prefilterPass.setExecute([&, shaded, reflections, reflectionsBlurred, prefiltered, ssr](const RenderGraph& graph)
+				{
+					depthOfField->focalDepth = focalDepth;
+					GLuint reflectionTexture = ssr ? graph.getTexture(reflections) : 0;
+					GLuint reflectionBlurTexture = ssr ? graph.getTexture(reflectionsBlurred) : 0;
+					depthOfField->prefilter(graph.getTexture(shaded), reflectionTexture, reflectionBlurTexture, graph.getTexture(prefiltered), camera->getProjectionMatrix());
+				});
+
+				RenderTargetDesc tileTarget;
+				tileTarget.width = screenTarget.width / DepthOfField::TILE_SIZE;
+				tileTarget.height = screenTarget.height / DepthOfField::TILE_SIZE;
+				tileTarget.format = GL_R16F;
+				RenderPassBuilder tilePass = graph.addPass("DOF Tiles");
+				tilePass.read(prefiltered);
+				RenderResource tiles = tilePass.create("DOF Tiles", tileTarget);
+				RenderResource dilatedTiles = tilePass.create("DOF Tiles Dilated", tileTarget);
+				tilePass.setExecute([&, prefiltered, tiles, dilatedTiles](const RenderGraph& graph)
+				{
+					depthOfField->buildTiles(graph.getTexture(prefiltered), graph.getTexture(tiles), graph.getTexture(dilatedTiles));
+				});
+
+				RenderTargetDesc gatherTarget = prefilterTarget;
+				gatherTarget.width = screenTarget.width / 4;
+				gatherTarget.height = screenTarget.height / 4;
+				RenderPassBuilder gatherPass = graph.addPass("DOF Gather");
+				gatherPass.read(prefiltered);
+				gatherPass.read(dilatedTiles);
+				dofBlur = gatherPass.create("DOF Blur", gatherTarget);
+				gatherPass.setExecute([&, prefiltered, dilatedTiles, dofBlur](const RenderGraph& graph)
+				{
+					depthOfField->gather(graph.getTexture(prefiltered), graph.getTexture(dilatedTiles), graph.getTexture(dofBlur));
+				});
 			}
-			else if (useSsr & !useBloom) {
-				glBindTexture(GL_TEXTURE_2D, reflectionsBlendBuffer.texture);
+
+			// composites the final image in one pass, with a program for the enabled effects, into the default framebuffer
+			// or for TAA or the upscaler into a target they read
+			RenderResource composited = backbuffer;
+			{
+				unsigned int features = (ssr ? COMPOSITE_REFLECTIONS : 0) | (dof ? COMPOSITE_DOF : 0) | (useBloom ? COMPOSITE_BLOOM : 0);
+				RenderPassBuilder pass = graph.addPass("Composite");
+				pass.read(shaded);
+				if (deferred) pass.read(gbufferTargets);
+				if (ssr)
+				{
+					pass.read(reflections);
+					pass.read(reflectionsBlurred);
+				}
+				if (dof) pass.read(dofBlur);
+				if (useBloom) pass.read(bloom);
+				if (taa) composited = pass.create("Composited", screenTarget);
+				else if (upscale) composited = pass.create("Final", screenTarget);
+				else composited = backbuffer = pass.write(backbuffer);
+				pass.setExecute([&, shaded, reflections, reflectionsBlurred, dofBlur, bloom, features, composited](const RenderGraph& graph)
+				{
+					glBindFramebuffer(GL_FRAMEBUFFER, graph.getFramebuffer(composited));
+					glClear(GL_COLOR_BUFFER_BIT);
+
+					gbuffer.bindTextures();
+					glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 1);
+					glBindTexture(GL_TEXTURE_2D, graph.getTexture(shaded));
+					if (features & COMPOSITE_REFLECTIONS)
+					{
+						glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 2);
+						glBindTexture(GL_TEXTURE_2D, graph.getTexture(reflections));
+						glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 3);
+						glBindTexture(GL_TEXTURE_2D, graph.getTexture(reflectionsBlurred));
+					}
+					if (features & COMPOSITE_DOF)
+					{
+						glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 4);
+						glBindTexture(GL_TEXTURE_2D, graph.getTexture(dofBlur));
+					}
+					if (features & COMPOSITE_BLOOM)
+					{
+						glActiveTexture(GL_TEXTURE0 + GBuffer::GB_DEPTH_UNIT + 5);
+						glBindTexture(GL_TEXTURE_2D, graph.getTexture(bloom));
+					}
+
+					ShaderProgram* compositeProgram = compositePrograms->get(features);
+					Matrix4 projection = camera->getProjectionMatrix();
+					compositeProgram->use();
+					compositeProgram->setUniform("focalDepth", focalDepth);
+					compositeProgram->setUniform("depthLinearize", Vector2(projection.data[10], projection.data[14]));
+					compositeProgram->setUniform("bloomExposure", bloomExposure);
+					quad->draw();
+					compositeProgram->unuse();
+				});
 			}
-			else if (!useSsr & !useBloom){
-				glBindTexture(GL_TEXTURE_2D, shadedBuffer.texture);
+
+			if (taa)
+			{
+				RenderTargetDesc motionTarget = screenTarget;
+				motionTarget.format = GL_RG16F;
+				RenderPassBuilder motionPass = graph.addPass("Motion Vectors");
+				motionPass.read(shaded);
+				RenderResource motion = motionPass.create("Motion Vectors", motionTarget);
+				motionPass.setExecute([&, motion](const RenderGraph& graph)
+				{
+					motionVectorPass(graph.getFramebuffer(motion));
+				});
+
+				RenderResource history = graph.importTarget("TAA History", taaHistory.getHistoryFbo(), taaHistory.getHistoryTexture());
+				RenderResource resolved = graph.importTarget("TAA Resolved", taaHistory.getFbo(), taaHistory.getTexture());
+				RenderPassBuilder taaPass = graph.addPass("TAA");
+				taaPass.read(composited);
+				taaPass.read(motion);
+				taaPass.read(history);
+				taaPass.read(shaded);
+				resolved = taaPass.write(resolved);
+				if (!upscale) backbuffer = taaPass.write(backbuffer);
+				taaPass.setExecute([&, composited, motion, upscale](const RenderGraph& graph)
+				{
+					temporalAntiAliasingPass(graph.getTexture(composited), graph.getTexture(motion), !upscale);
+				});
+				composited = resolved;
+			}
+
+			if (upscale)
+			{
+				// the upscaled image only covers the window, in a target of the bucket size like the others
+				RenderPassBuilder upscalePass = graph.addPass("Upscale");
+				upscalePass.read(composited);
+				RenderResource upscaled = upscalePass.create("Upscaled", screenTarget);
+				upscalePass.setExecute([&, composited, upscaled](const RenderGraph& graph)
+				{
+					edgeAdaptiveUpscalePass(graph.getTexture(composited), graph.getFramebuffer(upscaled));
+				});
+
+				RenderPassBuilder sharpenPass = graph.addPass("Sharpen");
+				sharpenPass.read(upscaled);
+				backbuffer = sharpenPass.write(backbuffer);
+				sharpenPass.setExecute([&, upscaled](const RenderGraph& graph)
+				{
+					contrastAdaptiveSharpenPass(graph.getTexture(upscaled));
+				});
 			}
-			
-			glEnable(GL_BLEND);
-			glBlendEquation(GL_FUNC_ADD);
-			glBlendFunc(GL_ONE, GL_ONE);
-			
-			quad->draw();
-			dofProgram->unuse();
-			
-			glDisable(GL_BLEND);
 		}
 
+		graph.setOutput(backbuffer);
+		dynamicResolution->beginFrame();
+		graph.execute();
+		dynamicResolution->endFrame();
+		renderTargetPool.endFrame();
+		frameIndex++;
+		executedPasses = graph.getExecutedPasses();
+		culledPasses = graph.getCulledPassCount();
+
 		if (!catchCursor) handleImGui();
 
 		ImGui::Render();
@@ -635,24 +1695,89 @@ class MyApp : public App
 			ImGui::Checkbox("Enable DOF", &useDOF);
 			ImGui::Checkbox("Enable Reflections", &useSsr);
 			ImGui::Checkbox("Enable Ambient Occlusion", &useSsao);
-
-
-			ImGui::SliderInt("SSAO #Samples", &ambientSamples, 1, 64);
+			ImGui::Checkbox("Enable TAA", &useTaa);
+			if (useTaa) ImGui::SliderFloat("TAA Feedback", &taaFeedback, 0.02f, 0.5f);
+
+			// the budget of the render scale and of the quality governor
+			ImGui::SliderFloat("GPU Budget (ms)", &qualityGovernor->budgetMs, QualityGovernor::MIN_BUDGET_MS, QualityGovernor::MAX_BUDGET_MS);
+			ImGui::Checkbox("Dynamic Resolution", &dynamicResolution->enabled);
+			if (dynamicResolution->enabled) ImGui::SliderFloat("Minimum Scale", &dynamicResolution->minScale, 0.25f, 1.0f);
+			else ImGui::SliderFloat("Render Scale", &dynamicResolution->fixedScale, 0.25f, 1.0f);
+			ImGui::SliderFloat("Upscale Sharpness (stops)", &upscaleSharpness, 0.0f, 2.0f);
+			ImGui::Text("GPU %.2f ms, scale %.2f, %ux%u", dynamicResolution->getGpuTime(), dynamicResolution->getScale(), screenViewport->getWidth(), screenViewport->getHeight());
+
+
+			ImGui::RadioButton("Hemisphere SSAO", &ambientOcclusionMethod, HEMISPHERE_SSAO); ImGui::SameLine();
+			ImGui::RadioButton("GTAO (compute)", &ambientOcclusionMethod, GROUND_TRUTH_AO);
+			if (useSsao) ImGui::Text("Ambient occlusion: %.2f ms", ambientOcclusionTime / 1000000.0);
+			if (ambientOcclusionMethod == GROUND_TRUTH_AO)
+			{
+				ImGui::SliderInt("GTAO Directions", &gtaoDirections, 1, 4);
+				ImGui::SliderInt("GTAO Steps", &gtaoSteps, 1, 8);
+			}
+			else
+			{
+				ImGui::RadioButton("SSAO Full", &ssaoResolution, SSAO_FULL); ImGui::SameLine();
+				ImGui::RadioButton("Half", &ssaoResolution, SSAO_HALF); ImGui::SameLine();
+				ImGui::RadioButton("Quarter Resolution", &ssaoResolution, SSAO_QUARTER);
+				if (ssaoResolution == SSAO_FULL)
+				{
+					if (useTaa) ImGui::SliderInt("SSAO #Samples per Frame", &ambientSamplesPerFrame, 1, 64);
+					else ImGui::SliderInt("SSAO #Samples", &ambientSamples, 1, 64);
+					ImGui::RadioButton("Box Blur", &ssaoBlur, SSAO_BOX_BLUR); ImGui::SameLine();
+					ImGui::RadioButton("Gaussian", &ssaoBlur, SSAO_GAUSSIAN_BLUR); ImGui::SameLine();
+					ImGui::RadioButton("Bilateral", &ssaoBlur, SSAO_BILATERAL_BLUR);
+				}
+				else ImGui::SliderInt("SSAO #Samples per Frame", &ambientSamplesPerFrame, 1, 64);
+			}
 			ImGui::SliderFloat("SSAO Radius", &ambientRadius, 0.1f, 1.0f);
 			ImGui::SliderFloat("SSAO Bias", &ambientBias, 0.01f, 0.05f);
 
 			ImGui::SliderFloat("BLOOM Exposure", &bloomExposure, 0.0f, 1.0f);
-			ImGui::SliderInt("BLOOM Blur Amount", &bloomBlur, 0, 20);
-			ImGui::SliderFloat("BLOOM Threshold", &bloomThreshold, 0.01f, 1.f);
+			ImGui::SliderInt("BLOOM Mip Levels", &bloomLevels, 1, 8);
+			ImGui::SliderFloat("BLOOM Radius", &bloomRadius, 0.5f, 2.0f);
+			ImGui::SliderFloat("BLOOM Threshold", &bloomThreshold, 0.0f, 4.0f);
 
 			ImGui::SliderFloat("DOF Focal Depth", &focalDepth, -25.0f, 25.0f);
-			ImGui::SliderInt("DOF #Samples", &dofSamples, 1, 150);
 
 			ImGui::SliderFloat("SSR Max Ray Length", &maxRayDistance, 1.0f, 100.0f);
-			ImGui::SliderFloat("SSR Resolution", &stepResolution, 0.1f, 1.0f);
-			ImGui::SliderInt("SSR Iterations", &stepIterations, 50, 800);
+			ImGui::RadioButton("SSR Linear March", &reflectionTracing, LINEAR_MARCH); ImGui::SameLine();
+			ImGui::RadioButton("Hi-Z Trace", &reflectionTracing, HIZ_TRACE);
+			if (reflectionTracing == HIZ_TRACE)
+			{
+				ImGui::SliderInt("SSR Iterations", &hiZIterations, 8, 256);
+				ImGui::Checkbox("SSR Half Resolution Trace", &halfResolutionReflections);
+			}
+			else
+			{
+				ImGui::SliderFloat("SSR Resolution", &stepResolution, 0.1f, 1.0f);
+				ImGui::SliderInt("SSR Iterations", &stepIterations, 50, 800);
+			}
 			ImGui::SliderFloat("SSR Hit Tolerance", &tolerance, 0.025f, 0.9f);
 
+			// passes of the last frame, disabled effects neither run nor keep their targets
+			ImGui::TextColored(accentColor, "Render Graph");
+			ImGui::Text("%u passes, %u culled", (unsigned int)executedPasses.size(), culledPasses);
+			ImGui::Text("%u transient targets, %.1f MB", renderTargetPool.getTargetCount(), renderTargetPool.getAllocatedBytes() / (1024.f * 1024.f));
+			ImGui::Text("%ux%u viewport in %ux%u targets, %u reallocations", screenViewport->getWidth(), screenViewport->getHeight(), screenViewport->getTargetWidth(), screenViewport->getTargetHeight(), targetReallocations);
+			ImGui::Text("%u composite variants compiled", compositePrograms->getVariantCount());
+			ImGui::Text("GPU %.2f ms in passes", passTimer->getTotalTime());
+			for (const std::string& pass : executedPasses)
+			{
+				ImGui::BulletText("%s %.2f ms", pass.c_str(), passTimer->getTime(pass));
+			}
+
+			// pinned settings are left as they are, the export is loaded pinned at the next start
+			ImGui::TextColored(accentColor, "Quality Governor");
+			ImGui::Checkbox("Adjust Effect Quality", &qualityGovernor->enabled);
+			for (QualityGovernor::Setting& setting : qualityGovernor->getSettings())
+			{
+				ImGui::Checkbox(("Pin " + setting.name).c_str(), &setting.pinned);
+				ImGui::SameLine();
+				ImGui::Text("%d", *setting.value);
+			}
+			if (ImGui::Button("Export Settings")) qualityGovernor->save(qualitySettingsFile);
+
 			ImGui::End();
 		}
 
@@ -661,6 +1786,48 @@ class MyApp : public App
 
 			ImGui::Text("%.1f FPS", ImGui::GetIO().Framerate);
 
+			ImGui::TextColored(accentColor, "Render Path");
+			ImGui::RadioButton("Deferred", &renderPath, DEFERRED_RENDERING);
+			ImGui::SameLine();
+			ImGui::RadioButton("Forward+ (clustered)", &renderPath, FORWARD_PLUS_RENDERING);
+			if (renderPath == FORWARD_PLUS_RENDERING) ImGui::Text("SSAO, reflections and DOF need the GBuffer and are skipped");
+			if (renderPath == DEFERRED_RENDERING) ImGui::Checkbox("Visibility buffer geometry pass", &useVisibilityBuffer);
+			if (renderPath == DEFERRED_RENDERING && !useVisibilityBuffer)
+			{
+				ImGui::Checkbox("Depth prepass", &useDepthPrepass);
+				ImGui::RadioButton("No occlusion culling", &occlusionCullingMethod, NO_OCCLUSION_CULLING); ImGui::SameLine();
+				ImGui::RadioButton("GPU Hi-Z", &occlusionCullingMethod, GPU_OCCLUSION_CULLING); ImGui::SameLine();
+				ImGui::RadioButton("CPU rasterized", &occlusionCullingMethod, CPU_OCCLUSION_CULLING);
+				if (occlusionCullingMethod == GPU_OCCLUSION_CULLING)
+				{
+					const OcclusionCulling::Statistics& cullStats = occlusionCulling->getStatistics();
+					ImGui::Text("%u objects: %u + %u drawn, %u outside the frustum, %u occluded", cullStats.objects,
+						cullStats.drawnFirstPhase, cullStats.drawnSecondPhase, cullStats.outsideFrustum, cullStats.occluded);
+				}
+				if (occlusionCullingMethod == CPU_OCCLUSION_CULLING)
+				{
+					const SoftwareOcclusion::Statistics& cullStats = softwareOcclusion->getStatistics();
+					unsigned int tested = cullStats.objects - cullStats.outsideFrustum;
+					ImGui::Text("%u objects: %u outside the frustum, %u of %u occluded (%.0f%%)", cullStats.objects, cullStats.outsideFrustum,
+						cullStats.occluded, tested, tested > 0 ? 100.0 * cullStats.occluded / tested : 0.0);
+					ImGui::Text("%u occluder triangles on %u threads: %.2f ms setup, %.2f ms raster, %.2f ms test", cullStats.occluderTriangles,
+						cullStats.threads, cullStats.setupMilliseconds, cullStats.rasterMilliseconds, cullStats.testMilliseconds);
+				}
+			}
+			if (renderPath == FORWARD_PLUS_RENDERING || !useVisibilityBuffer)
+			{
+				ImGui::Text("Shading pass: %.2f fragments per pixel", shadedFragments / (double)(screenViewport->getWidth() * screenViewport->getHeight()));
+			}
+
+			ImGui::TextColored(accentColor, "GBuffer Layout");
+			for (int i = 0; i < GBuffer::GB_NUMBER_OF_LAYOUTS; i++)
+			{
+				ImGui::RadioButton(GBuffer::LAYOUTS[i].name, &gbufferLayout, i);
+			}
+			if (gbufferLayout != gbuffer.layout) setGBufferLayout((GBuffer::GB_LAYOUT)gbufferLayout);
+			unsigned int bytesPerPixel = gbuffer.getLayout().getBytesPerPixel();
+			ImGui::Text("%u bytes per pixel, %.1f MB", bytesPerPixel, bytesPerPixel * screenViewport->getTargetWidth() * screenViewport->getTargetHeight() / (1024.f * 1024.f));
+
 			// material properties (only applies to debug objects)
 			ImGui::TextColored(accentColor, "Material Properties");
 			
@@ -685,6 +1852,9 @@ class MyApp : public App
 			if (material->aoMap) ImGui::Checkbox("Use ambient occlusion from texture", &material->useAoMap);
 			if (!material->useAoMap || !material->aoMap) ImGui::SliderFloat("AO", &material->ao, 0.0f, 1.0f);
 
+			if (material->albedoMap) ImGui::Checkbox("Alpha test albedo", &material->alphaTest);
+			if (material->albedoMap && material->alphaTest) ImGui::SliderFloat("Alpha cutoff", &material->alphaCutoff, 0.0f, 1.0f);
+
 			// indirect lighting section
 			ImGui::TextColored(accentColor, "Indirect lighting");
 			ImGui::Text("Displayed Cube Map:");
@@ -704,18 +1874,39 @@ class MyApp : public App
 
 			// direct lighting
 			ImGui::TextColored(accentColor, "Direct Lighting:");
+			ImGui::RadioButton("Unculled", &lightingMethod, UNCULLED_LIGHTS); ImGui::SameLine();
+			ImGui::RadioButton("Tiled light culling", &lightingMethod, TILED_LIGHTS); ImGui::SameLine();
+			ImGui::RadioButton("Light volumes", &lightingMethod, LIGHT_VOLUMES);
+			ImGui::Text("%d lights, %ux%u tiles", (int)lights.size(), tiledLightCulling->tileCountX, tiledLightCulling->tileCountY);
+
 			static int selectedLight = 0;
-			ImGui::DragFloat3("Light Position", (float*)&lights[selectedLight].position, 0.2f, -25.f, 25.f);
-			ImGui::ColorEdit3("Color", (float*)&lights[selectedLight].color);
-			ImGui::DragFloat("Brightness", (float*)&lights[selectedLight].brightness, 0.1f, 0.f, 100.f);
+			if (!lights.empty())
+			{
+				// only edited lights are marked dirty and uploaded again
+				Light light = lights[selectedLight];
+				bool changed = ImGui::DragFloat3("Light Position", (float*)&light.position, 0.2f, -25.f, 25.f);
+				changed |= ImGui::ColorEdit3("Color", (float*)&light.color);
+				changed |= ImGui::DragFloat("Brightness", &light.brightness, 0.1f, 0.f, 100.f);
+				if (changed) lights.set(selectedLight, light);
+			}
 
-			if (ImGui::Button("Add Light")) { lights.push_back(Light(Vector3(), Vector3(1.f, 1.f, 1.f), 15.f)); }
+			if (ImGui::Button("Add Light")) { lights.add(Light(Vector3(), Vector3(1.f, 1.f, 1.f), 15.f)); }
 			ImGui::SameLine();
 			if (ImGui::Button("Remove Light") && lights.size() > 0)
 			{
-				lights.erase(lights.begin() + selectedLight);
+				lights.remove(selectedLight);
 				selectedLight = 0;
 			}
+			ImGui::SameLine();
+			if (ImGui::Button("Scatter 1000 Lanterns"))
+			{
+				// small lights spread over the ground to stress the light culling
+				for (int i = 0; i < 1000; i++)
+				{
+					Vector3 position(rand() / (float)RAND_MAX * 50.f - 25.f, 0.5f + rand() / (float)RAND_MAX * 2.5f, rand() / (float)RAND_MAX * 50.f - 25.f);
+					lights.add(Light(position, Vector3(1.f, 0.6f, 0.2f), 2.f));
+				}
+			}
 
 			ImGui::BeginChild("Scrolling");
 			for (int i = 0; i < lights.size(); i++)
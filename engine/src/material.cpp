@@ -55,5 +55,8 @@ namespace engine
 		program->setUniform("useMetallicTex", useMetallicMap && metallicMap);
 		program->setUniform("useRoughnessTex", useRoughnessMap && roughnessMap);
 		program->setUniform("useAoTex", useAoMap && aoMap);
+
+		program->setUniform("useAlphaTest", alphaTest && useAlbedoMap && albedoMap);
+		program->setUniform("alphaCutoff", alphaCutoff);
 	};
 }
\ No newline at end of file
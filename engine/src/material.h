@@ -25,6 +25,10 @@ namespace engine
 		bool useRoughnessMap = true;
 		bool useAoMap = true;
 
+		// discard texels of the albedo map with an alpha below the cutoff, in the depth prepass and the geometry pass
+		bool alphaTest = false;
+		float alphaCutoff = 0.5f;
+
 		std::string name = "unnamed";
 
 		Material() = default;
@@ -1023,6 +1023,25 @@ namespace engine
 			- data[3] * Matrix2(data[1], data[7], data[2], data[8]).determinant()
 			+ data[6] * Matrix2(data[1], data[4], data[2], data[5]).determinant();
 	}
+	float Matrix4::determinant() const
+	{
+		// pairwise 2x2 minors of the first two and last two columns
+		float s0 = data[0] * data[5] - data[4] * data[1];
+		float s1 = data[0] * data[6] - data[4] * data[2];
+		float s2 = data[0] * data[7] - data[4] * data[3];
+		float s3 = data[1] * data[6] - data[5] * data[2];
+		float s4 = data[1] * data[7] - data[5] * data[3];
+		float s5 = data[2] * data[7] - data[6] * data[3];
+
+		float c5 = data[10] * data[15] - data[14] * data[11];
+		float c4 = data[9] * data[15] - data[13] * data[11];
+		float c3 = data[9] * data[14] - data[13] * data[10];
+		float c2 = data[8] * data[15] - data[12] * data[11];
+		float c1 = data[8] * data[14] - data[12] * data[10];
+		float c0 = data[8] * data[13] - data[12] * data[9];
+
+		return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	}
 
 	Matrix2 Matrix2::inversed() const
 	{
@@ -1063,8 +1082,58 @@ namespace engine
 		}
 	}
 
+	Matrix4 Matrix4::inversed() const
+	{
+		const float* m = data;
+
+		float s0 = m[0] * m[5] - m[4] * m[1];
+		float s1 = m[0] * m[6] - m[4] * m[2];
+		float s2 = m[0] * m[7] - m[4] * m[3];
+		float s3 = m[1] * m[6] - m[5] * m[2];
+		float s4 = m[1] * m[7] - m[5] * m[3];
+		float s5 = m[2] * m[7] - m[6] * m[3];
+
+		float c5 = m[10] * m[15] - m[14] * m[11];
+		float c4 = m[9] * m[15] - m[13] * m[11];
+		float c3 = m[9] * m[14] - m[13] * m[10];
+		float c2 = m[8] * m[15] - m[12] * m[11];
+		float c1 = m[8] * m[14] - m[12] * m[10];
+		float c0 = m[8] * m[13] - m[12] * m[9];
+
+		float de = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+		if (de == 0)
+		{
+			throw MatrixNotInvertibleException();
+		}
+
+		// adjugate divided by the determinant, works on the raw array regardless of storage order
+		float inv = 1.0f / de;
+		Matrix4 result;
+		result.data[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inv;
+		result.data[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inv;
+		result.data[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inv;
+		result.data[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inv;
+
+		result.data[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inv;
+		result.data[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inv;
+		result.data[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inv;
+		result.data[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inv;
+
+		result.data[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inv;
+		result.data[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inv;
+		result.data[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inv;
+		result.data[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inv;
+
+		result.data[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inv;
+		result.data[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inv;
+		result.data[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inv;
+		result.data[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inv;
+		return result;
+	}
+
 	void Matrix2::inverse() { (*this) = inversed(); }
 	void Matrix3::inverse() { (*this) = inversed(); }
+	void Matrix4::inverse() { (*this) = inversed(); }
 
 	Matrix2 Matrix2::transposed() const
 	{
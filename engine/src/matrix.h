@@ -178,6 +178,11 @@ namespace engine
 		// subscript operator
 		float operator[](int index);
 
+		float determinant() const;
+
+		Matrix4 inversed() const;
+		void inverse();
+
 		Matrix4 transposed() const;
 		void transpose();
 
@@ -1,5 +1,7 @@
 #include "mesh.h"
 
+#include <algorithm>
+
 #include "exceptions.h"
 
 namespace engine
@@ -89,6 +91,13 @@ namespace engine
 
 	void Mesh::setup()
 	{
+		boundsMin = boundsMax = vertices.empty() ? Vector3(0, 0, 0) : vertices[0].position;
+		for (const Vertex& vertex : vertices)
+		{
+			boundsMin = Vector3(std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y), std::min(boundsMin.z, vertex.position.z));
+			boundsMax = Vector3(std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y), std::max(boundsMax.z, vertex.position.z));
+		}
+
 		glGenVertexArrays(1, &vaoId);
 
 		glBindVertexArray(vaoId);
@@ -131,4 +140,34 @@ namespace engine
 		glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
 		glBindVertexArray(0);
 	}
+
+	void Mesh::drawInstanced(GLsizei instanceCount)
+	{
+		glBindVertexArray(vaoId);
+		glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0, instanceCount);
+		glBindVertexArray(0);
+	}
+
+	void Mesh::drawIndirect(ShaderProgram* program, GLintptr offset)
+	{
+		if (material) {
+			material->bind(program);
+		}
+
+		glBindVertexArray(vaoId);
+		glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)offset);
+		glBindVertexArray(0);
+	}
+
+	GLuint Mesh::getIndexCount() const { return (GLuint)indices.size(); }
+	Vector3 Mesh::getBoundsMin() const { return boundsMin; }
+	Vector3 Mesh::getBoundsMax() const { return boundsMax; }
+	const std::vector<Vertex>& Mesh::getVertices() const { return vertices; }
+	const std::vector<GLuint>& Mesh::getIndices() const { return indices; }
+
+	void Mesh::bindStorageBuffers(GLuint vertexBindingPoint, GLuint indexBindingPoint) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, vertexBindingPoint, vboId);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, indexBindingPoint, eboId);
+	}
 }
\ No newline at end of file
@@ -46,6 +46,19 @@ namespace engine {
 		void setup();
 		Material* getMaterial();
 		void draw(ShaderProgram * program = nullptr);
+		// draws the geometry only, without binding the material
+		void drawInstanced(GLsizei instanceCount);
+		// draws with the DrawElementsIndirectCommand at offset in the bound GL_DRAW_INDIRECT_BUFFER
+		void drawIndirect(ShaderProgram* program, GLintptr offset);
+		GLuint getIndexCount() const;
+		// axis aligned bounds of the vertex positions in model space, computed by setup
+		Vector3 getBoundsMin() const;
+		Vector3 getBoundsMax() const;
+		// the geometry kept on the CPU, for passes processing the triangles without the GPU
+		const std::vector<Vertex>& getVertices() const;
+		const std::vector<GLuint>& getIndices() const;
+		// vertex and index buffer as shader storage, for passes fetching the triangles themselves
+		void bindStorageBuffers(GLuint vertexBindingPoint, GLuint indexBindingPoint) const;
 
 		// vertex attributes
 		static const GLuint VERTICES = 0;
@@ -56,7 +69,8 @@ namespace engine {
 		std::vector<Vertex> vertices;
 		std::vector<GLuint> indices;
 		
-		Material* material;
+		Material* material = nullptr;
+		Vector3 boundsMin, boundsMax;
 
 		GLuint vaoId = 0;
 		GLuint vboId = 0;
@@ -1,6 +1,8 @@
 #include "meshfactory.h"
 
 #include <vector>
+#include <cmath>
+#include <algorithm>
 
 namespace engine
 {
@@ -75,4 +77,62 @@ namespace engine
 		return mesh;
 	}
 #pragma endregion
+
+#pragma region Sphere
+	Mesh* MeshFactory::createSphere(unsigned int subdivisions)
+	{
+		// icosahedron, the vertices are normalized below
+		const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+		const Vector3 corners[12] = {
+			Vector3(-1, t, 0), Vector3(1, t, 0), Vector3(-1, -t, 0), Vector3(1, -t, 0),
+			Vector3(0, -1, t), Vector3(0, 1, t), Vector3(0, -1, -t), Vector3(0, 1, -t),
+			Vector3(t, 0, -1), Vector3(t, 0, 1), Vector3(-t, 0, -1), Vector3(-t, 0, 1)
+		};
+		const int faces[20][3] = {
+			{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+			{1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+			{3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+			{4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+		};
+
+		std::vector<Vector3> triangles;
+		for (const int* face : faces)
+		{
+			for (int i = 0; i < 3; i++) triangles.push_back(corners[face[i]].normalized());
+		}
+
+		// split every triangle into four and push the new vertices onto the sphere
+		for (unsigned int level = 0; level < subdivisions; level++)
+		{
+			std::vector<Vector3> subdivided;
+			for (size_t i = 0; i < triangles.size(); i += 3)
+			{
+				Vector3 a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+				Vector3 ab = ((a + b) * 0.5f).normalized();
+				Vector3 bc = ((b + c) * 0.5f).normalized();
+				Vector3 ca = ((c + a) * 0.5f).normalized();
+				for (const Vector3& v : { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca }) subdivided.push_back(v);
+			}
+			triangles = subdivided;
+		}
+
+		// the flat faces cut into the sphere, scale them out until the closest face touches it
+		float inradius = 1.f;
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			Vector3 normal = (triangles[i + 1] - triangles[i]).cross(triangles[i + 2] - triangles[i]).normalized();
+			inradius = std::min(inradius, std::abs(normal.dot(triangles[i])));
+		}
+
+		std::vector<Vertex> vertices;
+		for (const Vector3& position : triangles)
+		{
+			vertices.push_back(Vertex(position / inradius, Vector2(), position));
+		}
+
+		Mesh* mesh = new Mesh(vertices);
+		mesh->setup();
+		return mesh;
+	}
+#pragma endregion
 }
@@ -8,6 +8,8 @@ namespace engine {
 	public:
 		static Mesh* createCube();
 		static Mesh* createQuad();
+		// low poly icosphere whose faces enclose the unit sphere, used to bound spherical volumes
+		static Mesh* createSphere(unsigned int subdivisions = 1);
 	private:
 		MeshFactory();
 	};
@@ -41,6 +41,7 @@ namespace engine
 					{
 					case ALBEDO:
 						mat->albedoMap = texture;
+						mat->alphaTest = texture->hasAlphaChannel();
 						break;
 					case NORMAL:
 						mat->normalMap = texture;
@@ -19,7 +19,7 @@ namespace engine
     public:
         Model(const std::string& path);
         void draw(ShaderProgram* program) const override;
-        std::vector<Mesh*> getMeshes();
+        std::vector<Mesh*> getMeshes() override;
         std::vector<Material*> getMaterials();
     private:
         std::vector<Mesh*> meshes;
@@ -0,0 +1,249 @@
+#include "occlusionculling.h"
+
+#include <algorithm>
+
+namespace engine
+{
+	// matches the std430 layout of ObjectBounds in occlusionCull.comp
+	struct GpuObject
+	{
+		float boundsMin[4];
+		float boundsMax[4];
+	};
+
+	// DrawElementsIndirectCommand
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLuint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// matches the Statistics block of occlusionCull.comp
+	struct GpuStatistics
+	{
+		GLuint outsideFrustum;
+		GLuint drawnFirstPhase;
+		GLuint drawnSecondPhase;
+		GLuint occluded;
+	};
+
+	OcclusionCulling::OcclusionCulling(const ScreenViewport* viewport) : viewport(viewport)
+	{
+		hiZBuffer = new HiZBuffer(viewport, HiZBuffer::FARTHEST_DEPTH);
+
+		program = new ShaderProgram();
+		program->initCompute("shaders/general/occlusionCull.comp", {
+			"GROUP_SIZE " + std::to_string(GROUP_SIZE),
+			"HIZ_LEVELS " + std::to_string(HiZBuffer::LEVELS)
+		});
+		program->link();
+		program->use();
+		program->setUniform("hiZ", 0);
+		program->unuse();
+
+		glGenBuffers(1, &objectBuffer);
+		glGenBuffers(1, &commandBuffer);
+		glGenBuffers(FRAMES_IN_FLIGHT, statisticsBuffers);
+		for (GLuint buffer : statisticsBuffers)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuStatistics), nullptr, GL_DYNAMIC_READ);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	OcclusionCulling::~OcclusionCulling()
+	{
+		deleteBufferData();
+		for (GLsync fence : statisticsFences)
+		{
+			if (fence != nullptr) glDeleteSync(fence);
+		}
+		glDeleteBuffers(FRAMES_IN_FLIGHT, statisticsBuffers);
+		glDeleteBuffers(1, &objectBuffer);
+		glDeleteBuffers(1, &commandBuffer);
+		delete hiZBuffer;
+		delete program;
+	}
+
+	void OcclusionCulling::initialize(unsigned int windowWidth, unsigned int windowHeight)
+	{
+		hiZBuffer->initialize(windowWidth, windowHeight);
+		invalidate();
+	}
+
+	void OcclusionCulling::deleteBufferData()
+	{
+		hiZBuffer->deleteBufferData();
+		invalidate();
+	}
+
+	void OcclusionCulling::invalidate()
+	{
+		pyramidValid = false;
+	}
+
+	const OcclusionCulling::Statistics& OcclusionCulling::getStatistics() const
+	{
+		return statistics;
+	}
+
+	void OcclusionCulling::collectObjects(SceneNode* node, ShaderProgram* program)
+	{
+		// nodes without a program of their own draw with the one of their parent
+		if (node->getShaderProgram() != nullptr) program = node->getShaderProgram();
+
+		IDrawable* drawable = node->getDrawable();
+		if (drawable != nullptr)
+		{
+			Matrix4 modelMatrix = node->getModelMatrix();
+			Matrix3 normalMatrix = Matrix3(modelMatrix).inversed().transposed();
+			for (Mesh* mesh : drawable->getMeshes())
+			{
+				objects.push_back({ mesh, program, modelMatrix, normalMatrix });
+			}
+		}
+
+		for (SceneNode* child : node->getNodes())
+		{
+			collectObjects(child, program);
+		}
+	}
+
+	void OcclusionCulling::uploadObjects()
+	{
+		std::vector<GpuObject> gpuObjects(objects.size());
+		// every command starts hidden, the culling sets the instance count of the drawn ones
+		std::vector<DrawCommand> commands(objects.size() * 2);
+		for (size_t i = 0; i < objects.size(); i++)
+		{
+			// world space box around the transformed corners of the model space box
+			Vector3 localMin = objects[i].mesh->getBoundsMin();
+			Vector3 localMax = objects[i].mesh->getBoundsMax();
+			Vector3 worldMin(1e30f, 1e30f, 1e30f), worldMax(-1e30f, -1e30f, -1e30f);
+			for (int corner = 0; corner < 8; corner++)
+			{
+				Vector4 position = objects[i].modelMatrix * Vector4(corner & 1 ? localMax.x : localMin.x, corner & 2 ? localMax.y : localMin.y, corner & 4 ? localMax.z : localMin.z, 1.f);
+				worldMin = Vector3(std::min(worldMin.x, position.x), std::min(worldMin.y, position.y), std::min(worldMin.z, position.z));
+				worldMax = Vector3(std::max(worldMax.x, position.x), std::max(worldMax.y, position.y), std::max(worldMax.z, position.z));
+			}
+			gpuObjects[i] = { { worldMin.x, worldMin.y, worldMin.z, 0.f }, { worldMax.x, worldMax.y, worldMax.z, 0.f } };
+
+			DrawCommand command = { objects[i].mesh->getIndexCount(), 0, 0, 0, 0 };
+			commands[i] = command;
+			commands[objects.size() + i] = command;
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, gpuObjects.size() * sizeof(GpuObject), gpuObjects.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	void OcclusionCulling::readStatistics()
+	{
+		// the counts of the frame that last used this buffer, dropped if the GPU is still behind it
+		unsigned int slot = frame % FRAMES_IN_FLIGHT;
+		GLsync fence = statisticsFences[slot];
+		if (fence == nullptr) return;
+
+		GLenum status = glClientWaitSync(fence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+		{
+			GpuStatistics counts;
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, statisticsBuffers[slot]);
+			glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counts), &counts);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+			statistics.objects = statisticsObjects[slot];
+			statistics.outsideFrustum = counts.outsideFrustum;
+			statistics.drawnFirstPhase = counts.drawnFirstPhase;
+			statistics.drawnSecondPhase = counts.drawnSecondPhase;
+			statistics.occluded = counts.occluded;
+		}
+		glDeleteSync(fence);
+		statisticsFences[slot] = nullptr;
+	}
+
+	void OcclusionCulling::beginFrame(SceneNode* root, const Matrix4& viewProjection)
+	{
+		this->viewProjection = viewProjection;
+		objects.clear();
+		collectObjects(root, nullptr);
+		uploadObjects();
+
+		readStatistics();
+		unsigned int slot = frame % FRAMES_IN_FLIGHT;
+		const GpuStatistics zero = {};
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, statisticsBuffers[slot]);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		statisticsObjects[slot] = (unsigned int)objects.size();
+
+		cull(FIRST_PHASE);
+	}
+
+	void OcclusionCulling::cull(Phase phase)
+	{
+		if (objects.empty()) return;
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, hiZBuffer->texture);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BP, objectBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BUFFER_BP, commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STATISTICS_BUFFER_BP, statisticsBuffers[frame % FRAMES_IN_FLIGHT]);
+
+		program->use();
+		program->setUniform("objectCount", (int)objects.size());
+		program->setUniform("secondPhase", phase == SECOND_PHASE);
+		program->setUniform("viewProjection", viewProjection);
+		program->setUniform("pyramidViewProjection", pyramidViewProjection);
+		program->setUniform("pyramidValid", pyramidValid);
+		program->setUniform("pyramidSize", Vector2((float)pyramidWidth, (float)pyramidHeight));
+		glDispatchCompute(((GLuint)objects.size() + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+		program->unuse();
+
+		// the commands are read by the indirect draws, the second phase reads the ones of the first
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	void OcclusionCulling::draw(Phase phase, ShaderProgram* programOverride)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		GLintptr offset = phase == FIRST_PHASE ? 0 : (GLintptr)(objects.size() * sizeof(DrawCommand));
+		for (Object& object : objects)
+		{
+			ShaderProgram* objectProgram = programOverride ? programOverride : object.program;
+			objectProgram->use();
+			objectProgram->setUniform("ModelMatrix", object.modelMatrix);
+			objectProgram->setUniform("NormalMatrix", object.normalMatrix);
+			object.mesh->drawIndirect(objectProgram, offset);
+			objectProgram->unuse();
+			offset += sizeof(DrawCommand);
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	void OcclusionCulling::cullDisoccluded(GLuint depthTexture)
+	{
+		hiZBuffer->build(depthTexture);
+		pyramidViewProjection = viewProjection;
+		pyramidWidth = viewport->getWidth();
+		pyramidHeight = viewport->getHeight();
+		pyramidValid = true;
+
+		cull(SECOND_PHASE);
+	}
+
+	void OcclusionCulling::endFrame(GLuint depthTexture)
+	{
+		hiZBuffer->build(depthTexture);
+
+		statisticsFences[frame % FRAMES_IN_FLIGHT] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		frame++;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "camera.h"
+#include "hizbuffer.h"
+#include "mesh.h"
+#include "scenegraph.h"
+#include "screenviewport.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Two phase occlusion culling of the geometry pass on the GPU. The scene is flattened into one indirect draw per mesh
+	// of a node whose instance count a compute pass sets to 0 or 1 from the world space bounds, so nothing is read back.
+	// The first phase draws what is inside the frustum and was visible last frame, tested with last frame's matrices
+	// against a farthest depth Hi-Z pyramid of last frame's depth. The pyramid is then rebuilt from the depth of the first
+	// phase and the second phase draws the objects it rejected that became visible this frame. After the second phase
+	// the pyramid is built from the complete depth for the next frame.
+	class OcclusionCulling
+	{
+	public:
+		static const GLuint GROUP_SIZE = 64;
+		// shader storage binding points while culling, fixed in the shader
+		static const GLuint OBJECT_BUFFER_BP = 2;
+		static const GLuint COMMAND_BUFFER_BP = 3;
+		static const GLuint STATISTICS_BUFFER_BP = 4;
+		// frames whose statistics can be in flight
+		static const unsigned int FRAMES_IN_FLIGHT = 4;
+
+		enum Phase { FIRST_PHASE, SECOND_PHASE };
+
+		// object counts of a frame, read back without stalling a few frames later
+		struct Statistics
+		{
+			unsigned int objects = 0;
+			unsigned int outsideFrustum = 0;
+			unsigned int drawnFirstPhase = 0;
+			unsigned int drawnSecondPhase = 0;
+			unsigned int occluded = 0;
+		};
+
+		OcclusionCulling(const ScreenViewport* viewport);
+		~OcclusionCulling();
+
+		// allocates the pyramid for targets this large, the next frame draws everything in the first phase
+		void initialize(unsigned int windowWidth, unsigned int windowHeight);
+		void deleteBufferData();
+
+		// collects the drawn meshes of the scene and culls them for the first phase
+		void beginFrame(SceneNode* root, const Matrix4& viewProjection);
+		// draws the objects of a phase with programOverride instead of their node's program if given
+		void draw(Phase phase, ShaderProgram* programOverride = nullptr);
+		// culls the objects rejected by the first phase against the depth the first phase left in depthTexture
+		void cullDisoccluded(GLuint depthTexture);
+		// builds the pyramid of the next frame from the complete depth
+		void endFrame(GLuint depthTexture);
+
+		// the next frame draws everything in the first phase, when the scene or the depth changed in other ways
+		void invalidate();
+
+		const Statistics& getStatistics() const;
+	private:
+		struct Object
+		{
+			Mesh* mesh;
+			ShaderProgram* program;
+			Matrix4 modelMatrix;
+			Matrix3 normalMatrix;
+		};
+
+		void collectObjects(SceneNode* node, ShaderProgram* program);
+		void uploadObjects();
+		void cull(Phase phase);
+		void readStatistics();
+
+		const ScreenViewport* viewport;
+		HiZBuffer* hiZBuffer = nullptr;
+		ShaderProgram* program = nullptr;
+
+		std::vector<Object> objects;
+		// world space bounds of the objects
+		GLuint objectBuffer = 0;
+		// the DrawElementsIndirectCommand of every object for the first phase followed by the ones for the second phase
+		GLuint commandBuffer = 0;
+
+		// the matrices and viewport the pyramid was built with
+		Matrix4 viewProjection;
+		Matrix4 pyramidViewProjection;
+		unsigned int pyramidWidth = 0, pyramidHeight = 0;
+		bool pyramidValid = false;
+
+		GLuint statisticsBuffers[FRAMES_IN_FLIGHT] = {};
+		GLsync statisticsFences[FRAMES_IN_FLIGHT] = {};
+		unsigned int statisticsObjects[FRAMES_IN_FLIGHT] = {};
+		unsigned int frame = 0;
+		Statistics statistics;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "passtimer.h"
+
+namespace engine
+{
+	// weight of a new measurement in the smoothed times
+	const double PASS_TIME_SMOOTHING = 0.2;
+
+	PassTimer::~PassTimer()
+	{
+		for (Frame& f : frames)
+		{
+			if (!f.queries.empty()) glDeleteQueries((GLsizei)f.queries.size(), f.queries.data());
+		}
+	}
+
+	void PassTimer::beginFrame()
+	{
+		// skips measuring while the GPU is still behind the frame that last used these queries
+		Frame& f = frames[frame % FRAMES_IN_FLIGHT];
+		measuring = !f.pending;
+		if (!measuring) return;
+		f.used = 0;
+		f.passes.clear();
+	}
+
+	void PassTimer::begin(const std::string& pass)
+	{
+		if (!measuring) return;
+		Frame& f = frames[frame % FRAMES_IN_FLIGHT];
+		if (f.queries.size() < f.used + 2)
+		{
+			f.queries.resize(f.used + 2);
+			glGenQueries(2, &f.queries[f.used]);
+		}
+		glQueryCounter(f.queries[f.used], GL_TIMESTAMP);
+		f.passes.push_back(pass);
+	}
+
+	void PassTimer::end()
+	{
+		if (!measuring) return;
+		Frame& f = frames[frame % FRAMES_IN_FLIGHT];
+		glQueryCounter(f.queries[f.used + 1], GL_TIMESTAMP);
+		f.used += 2;
+	}
+
+	void PassTimer::endFrame()
+	{
+		if (measuring) frames[frame % FRAMES_IN_FLIGHT].pending = frames[frame % FRAMES_IN_FLIGHT].used > 0;
+		measuring = false;
+		frame++;
+	}
+
+	void PassTimer::update()
+	{
+		// oldest frame first, so the smoothed times follow the frame order
+		for (unsigned int i = 0; i < FRAMES_IN_FLIGHT; i++)
+		{
+			Frame& f = frames[(frame + i) % FRAMES_IN_FLIGHT];
+			if (!f.pending) continue;
+			GLint available = 0;
+			glGetQueryObjectiv(f.queries[f.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) continue;
+			f.pending = false;
+
+			std::map<std::string, double> frameTimes;
+			double frameTotal = 0.0;
+			for (unsigned int pass = 0; pass < f.passes.size(); pass++)
+			{
+				GLuint64 start = 0, end = 0;
+				glGetQueryObjectui64v(f.queries[pass * 2], GL_QUERY_RESULT, &start);
+				glGetQueryObjectui64v(f.queries[pass * 2 + 1], GL_QUERY_RESULT, &end);
+				double time = (end - start) / 1000000.0;
+				frameTimes[f.passes[pass]] += time;
+				frameTotal += time;
+			}
+
+			// passes that did not run are dropped, the others continue from their last time
+			for (std::pair<const std::string, double>& pass : frameTimes)
+			{
+				std::map<std::string, double>::const_iterator last = times.find(pass.first);
+				if (last != times.end()) pass.second = last->second + (pass.second - last->second) * PASS_TIME_SMOOTHING;
+			}
+			times.swap(frameTimes);
+			totalTime = measuredFrames > 0 ? totalTime + (frameTotal - totalTime) * PASS_TIME_SMOOTHING : frameTotal;
+			measuredFrames++;
+		}
+	}
+
+	double PassTimer::getTime(const std::string& pass) const
+	{
+		std::map<std::string, double>::const_iterator it = times.find(pass);
+		return it == times.end() ? 0.0 : it->second;
+	}
+
+	double PassTimer::getTotalTime() const { return totalTime; }
+	const std::map<std::string, double>& PassTimer::getTimes() const { return times; }
+	unsigned int PassTimer::getMeasuredFrames() const { return measuredFrames; }
+}
\ No newline at end of file
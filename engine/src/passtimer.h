@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace engine
+{
+	// GPU time of every render graph pass. Timestamps are written around each pass and read back a few frames later,
+	// once the GPU passed them, so measuring never stalls. Passes with the same name in a frame add up.
+	class PassTimer
+	{
+	public:
+		// frames whose timestamps can be in flight
+		static const unsigned int FRAMES_IN_FLIGHT = 4;
+
+		~PassTimer();
+
+		void beginFrame();
+		void begin(const std::string& pass);
+		void end();
+		void endFrame();
+
+		// reads back the frames the GPU finished
+		void update();
+
+		// smoothed time of the pass in milliseconds, 0 for passes that did not run in the last measured frame
+		double getTime(const std::string& pass) const;
+		// smoothed time of all passes of a frame
+		double getTotalTime() const;
+		const std::map<std::string, double>& getTimes() const;
+		// frames measured so far, to tell fresh measurements from old ones
+		unsigned int getMeasuredFrames() const;
+	private:
+		struct Frame
+		{
+			// a start and an end timestamp per pass
+			std::vector<GLuint> queries;
+			std::vector<std::string> passes;
+			unsigned int used = 0;
+			bool pending = false;
+		};
+
+		Frame frames[FRAMES_IN_FLIGHT];
+		unsigned int frame = 0;
+		bool measuring = false;
+
+		std::map<std::string, double> times;
+		double totalTime = 0.0;
+		unsigned int measuredFrames = 0;
+	};
+}
\ No newline at end of file
@@ -15,16 +15,24 @@ namespace engine {
 		glGenTextures(1, &texture);
 		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+		glGenTextures(1, &brightTexture);
+		glBindTexture(GL_TEXTURE_2D, brightTexture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, windowWidth, windowHeight);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, brightTexture, 0);
 		glGenTextures(1, &depthTexture);
 		glBindTexture(GL_TEXTURE_2D, depthTexture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, windowWidth, windowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, windowWidth, windowHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
 		GLenum DrawBuffersShade[] = { GL_COLOR_ATTACHMENT0 };
 		glDrawBuffers(1, DrawBuffersShade);
 	}
@@ -34,163 +42,72 @@ namespace engine {
 			glDeleteFramebuffers(1, &fbo);
 		if (texture != 0)
 			glDeleteTextures(1, &texture);
+		if (brightTexture != 0)
+			glDeleteTextures(1, &brightTexture);
 		if (depthTexture != 0)
 			glDeleteTextures(1, &depthTexture);
 	}
 
-	BloomBuffer::BloomBuffer() {};
-	BloomBuffer::~BloomBuffer() { BloomBuffer::deleteBufferData(); };
-
-	void BloomBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight) {
-		glGenFramebuffers(1, &fbo);
-		glGenTextures(1, &texture);
+	void ShadedBuffer::setBrightPass(bool enabled) {
+		GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
 		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-		GLenum DrawBuffersBloom[] = { GL_COLOR_ATTACHMENT0 };
-		glDrawBuffers(1, DrawBuffersBloom);
+		glDrawBuffers(enabled ? 2 : 1, drawBuffers);
 	}
 
-	void BloomBuffer::deleteBufferData() {
-		if (fbo != 0)
-			glDeleteFramebuffers(1, &fbo);
-		if (texture != 0)
-			glDeleteTextures(1, &texture);
-	}
-
-	ReflectionsBuffer::ReflectionsBuffer() {};
-	ReflectionsBuffer::~ReflectionsBuffer() { ReflectionsBuffer::deleteBufferData(); };
+	HistoryBuffer::HistoryBuffer(GLenum format) : format(format) {};
+	HistoryBuffer::~HistoryBuffer() { HistoryBuffer::deleteBufferData(); };
 
-	void ReflectionsBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight) {
-		glGenFramebuffers(1, &fbo);
-		glGenTextures(1, &texture);
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-		GLenum DrawBuffersReflection[] = { GL_COLOR_ATTACHMENT0 };
-		glDrawBuffers(1, DrawBuffersReflection);
-	}
-
-	void ReflectionsBuffer::deleteBufferData() {
-		if (fbo != 0)
-			glDeleteFramebuffers(1, &fbo);
-		if (texture != 0)
-			glDeleteTextures(1, &texture);
-	}
-
-	ReflectionsBlendBuffer::ReflectionsBlendBuffer() {};
-	ReflectionsBlendBuffer::~ReflectionsBlendBuffer() { ReflectionsBlendBuffer::deleteBufferData(); };
-
-	void ReflectionsBlendBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight) {
-		glGenFramebuffers(1, &fbo);
-		glGenTextures(1, &texture);
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-		GLenum DrawBuffersReflection[] = { GL_COLOR_ATTACHMENT0 };
-		glDrawBuffers(1, DrawBuffersReflection);
-	}
-
-	void ReflectionsBlendBuffer::deleteBufferData() {
-		if (fbo != 0)
-			glDeleteFramebuffers(1, &fbo);
-		if (texture != 0)
-			glDeleteTextures(1, &texture);
-	}
-
-	BlurBuffer::BlurBuffer() {};
-	BlurBuffer::~BlurBuffer() { BlurBuffer::deleteBufferData(); };
-
-	void BlurBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight) {
-		glGenFramebuffers(1, &fbo);
-		glGenTextures(1, &texture);
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-		GLenum DrawBuffersBlur[] = { GL_COLOR_ATTACHMENT0 };
-		glDrawBuffers(1, DrawBuffersBlur);
-	}
-
-	void BlurBuffer::deleteBufferData() {
-		if (fbo != 0)
-			glDeleteFramebuffers(1, &fbo);
-		if (texture != 0)
-			glDeleteTextures(1, &texture);
-	}
-
-	PingPongBuffer::PingPongBuffer() {};
-	PingPongBuffer::~PingPongBuffer() { PingPongBuffer::deleteBufferData(); };
-
-	void PingPongBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight) {
+	void HistoryBuffer::initialize(unsigned int width, unsigned int height) {
+		this->width = width;
+		this->height = height;
 		glGenFramebuffers(2, fbo);
 		glGenTextures(2, texture);
-		for (unsigned int i = 0; i < 2; i++)
+		for (int i = 0; i < 2; i++)
 		{
 			glBindFramebuffer(GL_FRAMEBUFFER, fbo[i]);
 			glBindTexture(GL_TEXTURE_2D, texture[i]);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+			glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+			// reprojected history lies between texels
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture[i], 0);
 		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		valid = false;
 	}
 
-	void PingPongBuffer::deleteBufferData() {
-		if (fbo != 0)
+	void HistoryBuffer::deleteBufferData() {
+		if (fbo[0] != 0)
 			glDeleteFramebuffers(2, fbo);
 		if (texture[0] != 0)
 			glDeleteTextures(2, texture);
+		fbo[0] = fbo[1] = 0;
+		texture[0] = texture[1] = 0;
+		width = height = 0;
+		valid = false;
+	}
+
+	void HistoryBuffer::swap() {
+		current ^= 1;
+		valid = true;
 	}
 
 	SsaoBuffer::SsaoBuffer() {};
 	SsaoBuffer::~SsaoBuffer() { 
-		SsaoBuffer::deleteBufferData();
 		if (noiseTexture != 0)
 			glDeleteTextures(1, &noiseTexture);
+		SsaoBuffer::deleteBufferData();
 	};
 
-	void SsaoBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight) {
-		glGenFramebuffers(1, &fbo);
-		glGenTextures(1, &texture);
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-		GLenum DrawBuffersSsao[] = { GL_COLOR_ATTACHMENT0 };
-		glDrawBuffers(1, DrawBuffersSsao);
+	void SsaoBuffer::initialize(unsigned int width, unsigned int height) {
+		history.initialize(width, height);
 	}
 
 	void SsaoBuffer::deleteBufferData() {
-		if (fbo != 0)
-			glDeleteFramebuffers(1, &fbo);
-		if (texture != 0)
-			glDeleteTextures(1, &texture);
+		history.deleteBufferData();
 	}
 
 	void SsaoBuffer::generateSampleKernel() {
@@ -20,93 +20,63 @@ namespace engine {
 
 		GLuint fbo = 0;
 		GLuint texture = 0;
+		// bright part of the shaded color for bloom and its log luminance, written by the lighting passes as a second
+		// attachment while the bright pass is enabled
+		GLuint brightTexture = 0;
 		GLuint depthTexture = 0;
 
 		void initialize(unsigned int windowWidth, unsigned int windowHeight);
 		void deleteBufferData();
+		// draws to the bright texture as well, only shaders writing its output may draw while it is enabled
+		void setBrightPass(bool enabled);
 	};
 
-	class BloomBuffer : public PostProcessBuffer {
+	// pair of targets a temporal pass alternates between, every frame reads the one written the frame before as its
+	// history and writes the other, the targets have immutable storage and linear filtering for reprojected reads
+	class HistoryBuffer : public PostProcessBuffer {
 	public:
-
-		BloomBuffer();
-		~BloomBuffer();
-
-		GLuint fbo = 0;
-		GLuint texture = 0;
-
-		void initialize(unsigned int windowWidth, unsigned int windowHeight);
-		void deleteBufferData();
-	};
-
-	class ReflectionsBuffer : public PostProcessBuffer {
-	public:
-
-		ReflectionsBuffer();
-		~ReflectionsBuffer();
-
-		GLuint fbo = 0;
-		GLuint texture = 0;
-
-		void initialize(unsigned int windowWidth, unsigned int windowHeight);
-		void deleteBufferData();
-	};
-
-	class ReflectionsBlendBuffer : public PostProcessBuffer {
-	public:
-
-		ReflectionsBlendBuffer();
-		~ReflectionsBlendBuffer();
-
-		GLuint fbo = 0;
-		GLuint texture = 0;
-
-		void initialize(unsigned int windowWidth, unsigned int windowHeight);
-		void deleteBufferData();
-	};
-
-	class BlurBuffer : public PostProcessBuffer {
-	public:
-
-		BlurBuffer();
-		~BlurBuffer();
-
-		GLuint fbo = 0;
-		GLuint texture = 0;
-
-		void initialize(unsigned int windowWidth, unsigned int windowHeight);
-		void deleteBufferData();
-	};
-
-	class PingPongBuffer : public PostProcessBuffer {
-	public:
-
-		PingPongBuffer();
-		~PingPongBuffer();
-
-		GLuint fbo[2];
-		GLuint texture[2];
-
-		void initialize(unsigned int windowWidth, unsigned int windowHeight);
+		HistoryBuffer(GLenum format);
+		~HistoryBuffer();
+
+		GLenum format;
+		GLuint fbo[2] = { 0, 0 };
+		GLuint texture[2] = { 0, 0 };
+		unsigned int width = 0, height = 0;
+		// index of the target written this frame
+		unsigned int current = 0;
+		// cleared whenever the last frame did not write a history matching the current viewport
+		bool valid = false;
+
+		GLuint getFbo() const { return fbo[current]; }
+		GLuint getTexture() const { return texture[current]; }
+		GLuint getHistoryFbo() const { return fbo[current ^ 1]; }
+		GLuint getHistoryTexture() const { return texture[current ^ 1]; }
+		// after writing, turns this frame's target into the history of the next frame
+		void swap();
+
+		void initialize(unsigned int width, unsigned int height);
 		void deleteBufferData();
 	};
 
+	// sample kernel and noise of the SSAO pass and the history its reduced resolution modes accumulate across frames,
+	// the other targets are transient render graph resources
 	class SsaoBuffer : public PostProcessBuffer {
 	public: 
 		SsaoBuffer();
 		~SsaoBuffer();
 
-		GLuint fbo = 0;
-		GLuint texture = 0;
-
 		GLuint noiseTexture = 0;
 
+		// occlusion, linear depth and accumulated frame count
+		HistoryBuffer history{ GL_RGBA16F };
+
 		std::vector<Vector3> ssaoKernel;
 
-		void initialize(unsigned int windowWidth, unsigned int windowHeight);
-		void deleteBufferData();
 		void generateSampleKernel();
 		void generateNoiseTexture();
+
+		void initialize(unsigned int width, unsigned int height);
+		void deleteBufferData();
 	};
 }
 
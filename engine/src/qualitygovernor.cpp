@@ -0,0 +1,172 @@
+#include "qualitygovernor.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace engine
+{
+	const float QualityGovernor::MIN_BUDGET_MS = 4.f;
+	const float QualityGovernor::MAX_BUDGET_MS = 33.f;
+
+	void QualityGovernor::add(const std::string& name, int* value, int cheapest, int best, int step, int lowest, int highest, int priority, const std::vector<std::string>& passes, const std::function<bool()>& active)
+	{
+		Setting setting;
+		setting.name = name;
+		setting.value = value;
+		setting.cheapest = cheapest;
+		setting.best = best;
+		// points from the cheapest towards the best value
+		setting.step = best < cheapest ? -std::abs(step) : std::abs(step);
+		setting.lowest = lowest;
+		setting.highest = highest;
+		setting.priority = priority;
+		setting.passes = passes;
+		setting.active = active;
+		settings.push_back(setting);
+	}
+
+	bool QualityGovernor::isAdjustable(const Setting& setting, const PassTimer& timer) const
+	{
+		if (setting.pinned) return false;
+		if (setting.active && !setting.active()) return false;
+		return getCost(setting, timer) > 0.0;
+	}
+
+	double QualityGovernor::getCost(const Setting& setting, const PassTimer& timer) const
+	{
+		double cost = 0.0;
+		for (const std::string& pass : setting.passes)
+		{
+			cost += timer.getTime(pass);
+		}
+		return cost;
+	}
+
+	bool QualityGovernor::update(const PassTimer& timer, bool mayLower, bool mayRaise)
+	{
+		for (Setting& setting : settings)
+		{
+			if (setting.blockedFrames > 0) setting.blockedFrames--;
+		}
+
+		// waits until frames rendered after the last change were measured
+		if (timer.getMeasuredFrames() == measuredFrames) return false;
+		measuredFrames = timer.getMeasuredFrames();
+		if (settleFrames > 0)
+		{
+			settleFrames--;
+			return false;
+		}
+		if (!enabled) return false;
+
+		double total = timer.getTotalTime();
+		Setting* chosen = nullptr;
+		if (total > budgetMs)
+		{
+			if (!mayLower) return false;
+			// the lowest priority first, the most expensive of equal priority
+			for (Setting& setting : settings)
+			{
+				if (!isAdjustable(setting, timer)) continue;
+				// past the cheapest value in its direction
+				if ((*setting.value - setting.cheapest) * setting.step <= 0) continue;
+				if (!chosen || setting.priority < chosen->priority || (setting.priority == chosen->priority && getCost(setting, timer) > getCost(*chosen, timer))) chosen = &setting;
+			}
+			if (!chosen) return false;
+			chosen->blockedValue = *chosen->value;
+			chosen->blockedFrames = BLOCK_FRAMES;
+			*chosen->value -= chosen->step;
+		}
+		else if (total < budgetMs * (1.f - margin))
+		{
+			if (!mayRaise) return false;
+			double headroom = budgetMs * (1.f - margin) - total;
+			for (Setting& setting : settings)
+			{
+				if (!isAdjustable(setting, timer)) continue;
+				int raised = *setting.value + setting.step;
+				if ((setting.best - raised) * setting.step < 0) continue;
+				if (setting.blockedFrames > 0 && (raised - setting.blockedValue) * setting.step >= 0) continue;
+				// the time of the passes is taken to grow linearly with the steps above the cheapest value
+				double steps = (*setting.value - setting.cheapest) / (double)setting.step + 1.0;
+				if (getCost(setting, timer) / steps > headroom) continue;
+				if (!chosen || setting.priority > chosen->priority) chosen = &setting;
+			}
+			if (!chosen) return false;
+			*chosen->value += chosen->step;
+		}
+		else
+		{
+			return false;
+		}
+
+		settleFrames = SETTLE_FRAMES;
+		return true;
+	}
+
+	bool QualityGovernor::save(const std::string& filename) const
+	{
+		std::ofstream out(filename);
+		if (!out) return false;
+		out << "enabled " << (enabled ? 1 : 0) << std::endl;
+		out << "budgetMs " << budgetMs << std::endl;
+		for (const Setting& setting : settings)
+		{
+			out << setting.name << " " << *setting.value << std::endl;
+		}
+		return true;
+	}
+
+	bool QualityGovernor::load(const std::string& filename)
+	{
+		std::ifstream in(filename);
+		if (!in) return false;
+
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::istringstream stream(line);
+			std::string name;
+			if (!(stream >> name)) continue;
+
+			std::string error;
+			if (name == "budgetMs")
+			{
+				float budget;
+				if (!(stream >> budget)) error = "no number";
+				else if (budget < MIN_BUDGET_MS || budget > MAX_BUDGET_MS) error = "outside " + std::to_string((int)MIN_BUDGET_MS) + ".." + std::to_string((int)MAX_BUDGET_MS);
+				else budgetMs = budget;
+			}
+			else
+			{
+				int value;
+				Setting* match = nullptr;
+				for (Setting& setting : settings)
+				{
+					if (setting.name == name) match = &setting;
+				}
+
+				if (!(stream >> value)) error = "no integer";
+				else if (name == "enabled")
+				{
+					if (value != 0 && value != 1) error = "not 0 or 1";
+					else enabled = value != 0;
+				}
+				else if (!match) error = "unknown setting";
+				else if (value < match->lowest || value > match->highest) error = "outside " + std::to_string(match->lowest) + ".." + std::to_string(match->highest);
+				else
+				{
+					*match->value = value;
+					match->pinned = true;
+				}
+			}
+
+			if (!error.empty()) std::cerr << "Ignored '" << line << "' in " << filename << ": " << error << std::endl;
+		}
+		return true;
+	}
+
+	std::vector<QualityGovernor::Setting>& QualityGovernor::getSettings() { return settings; }
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "passtimer.h"
+
+namespace engine
+{
+	// Moves effect parameters like sample and iteration counts towards a GPU time budget for the render graph passes.
+	// Over the budget it lowers the setting of the lowest priority whose passes ran, below the budget minus a margin it
+	// raises the one of the highest priority if the time it is expected to add still fits. After every change it waits
+	// for measurements of the new setting, and a setting lowered from a value is not raised back to it for a while, so
+	// the settings do not oscillate. The chosen settings can be saved and loaded pinned, which the governor leaves alone,
+	// along with whether it is enabled and its budget, so a deployment is configured by the file alone.
+	class QualityGovernor
+	{
+	public:
+		struct Setting
+		{
+			std::string name;
+			int* value;
+			// from the cheapest to the best value in steps, the best may be below the cheapest
+			int cheapest;
+			int best;
+			int step;
+			// valid values, the range of its UI control, loaded values outside it are rejected
+			int lowest;
+			int highest;
+			// lowered first and raised last with a lower priority
+			int priority;
+			// render graph passes whose time depends on the setting
+			std::vector<std::string> passes;
+			// whether the setting is in use, e.g. the method of an effect it belongs to is selected
+			std::function<bool()> active;
+			bool pinned = false;
+			// frames until it may be raised to blockedValue again
+			unsigned int blockedFrames = 0;
+			int blockedValue = 0;
+		};
+
+		// frames without another change after one, until the passes were measured with the new setting
+		static const unsigned int SETTLE_FRAMES = 2 * PassTimer::FRAMES_IN_FLIGHT + 4;
+		// frames a setting is not raised back to a value it was lowered from
+		static const unsigned int BLOCK_FRAMES = 300;
+		// valid budgets, the range of the UI control
+		static const float MIN_BUDGET_MS;
+		static const float MAX_BUDGET_MS;
+
+		void add(const std::string& name, int* value, int cheapest, int best, int step, int lowest, int highest, int priority, const std::vector<std::string>& passes, const std::function<bool()>& active = nullptr);
+
+		// adjusts at most one setting from the pass times, returns true if it did. Another controller of the same budget,
+		// like the render scale, can hold back lowering or raising until it reached its own limit in that direction.
+		bool update(const PassTimer& timer, bool mayLower = true, bool mayRaise = true);
+
+		// writes "name value" lines of enabled, budgetMs and every setting
+		bool save(const std::string& filename) const;
+		// reads enabled and budgetMs and sets and pins the settings listed in the file, returns false if it cannot be read.
+		// Lines with unknown names or values outside the valid range are reported and ignored.
+		bool load(const std::string& filename);
+
+		std::vector<Setting>& getSettings();
+
+		// on unless switched off in the UI or the settings file
+		bool enabled = true;
+		// GPU time of all passes to stay within, the frame budget shared with the render scale
+		float budgetMs = 15.f;
+		// settings are raised only below this part of the budget
+		float margin = 0.15f;
+	private:
+		bool isAdjustable(const Setting& setting, const PassTimer& timer) const;
+		double getCost(const Setting& setting, const PassTimer& timer) const;
+
+		std::vector<Setting> settings;
+		unsigned int settleFrames = 0;
+		unsigned int measuredFrames = 0;
+	};
+}
\ No newline at end of file
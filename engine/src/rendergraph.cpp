@@ -0,0 +1,400 @@
+#include "rendergraph.h"
+
+#include <algorithm>
+
+#include "exceptions.h"
+#include "passtimer.h"
+
+namespace engine
+{
+	static size_t formatBytes(GLenum format)
+	{
+		switch (format)
+		{
+		case GL_R8: return 1;
+		case GL_RG8:
+		case GL_R16F: return 2;
+		case GL_RGBA8:
+		case GL_RG16F:
+		case GL_R32F:
+		case GL_RGB10_A2:
+		case GL_R11F_G11F_B10F:
+		case GL_DEPTH24_STENCIL8: return 4;
+		case GL_RGBA16F: return 8;
+		case GL_RGBA32F: return 16;
+		default: return 4;
+		}
+	}
+
+	/* RenderTargetDesc */
+	bool RenderTargetDesc::operator==(const RenderTargetDesc& other) const
+	{
+		return width == other.width && height == other.height && format == other.format && filter == other.filter && depthStencil == other.depthStencil;
+	}
+
+	size_t RenderTargetDesc::getBytes() const
+	{
+		size_t bytes = formatBytes(format);
+		if (depthStencil) bytes += formatBytes(GL_DEPTH24_STENCIL8);
+		return bytes * width * height;
+	}
+
+	/* RenderTargetPool */
+	RenderTargetPool::~RenderTargetPool()
+	{
+		clear();
+	}
+
+	RenderTarget* RenderTargetPool::acquire(const RenderTargetDesc& desc)
+	{
+		for (Entry& entry : entries)
+		{
+			if (!entry.inUse && entry.target->desc == desc)
+			{
+				entry.inUse = true;
+				entry.unusedFrames = 0;
+				return entry.target;
+			}
+		}
+
+		RenderTarget* target = new RenderTarget();
+		target->desc = desc;
+
+		glGenFramebuffers(1, &target->fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+		glGenTextures(1, &target->texture);
+		glBindTexture(GL_TEXTURE_2D, target->texture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, desc.format, desc.width, desc.height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->texture, 0);
+
+		if (desc.depthStencil)
+		{
+			glGenTextures(1, &target->depthStencilTexture);
+			glBindTexture(GL_TEXTURE_2D, target->depthStencilTexture);
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, desc.width, desc.height);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, target->depthStencilTexture, 0);
+		}
+
+		GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0 };
+		glDrawBuffers(1, drawBuffers);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		entries.push_back({ target, true, 0 });
+		return target;
+	}
+
+	void RenderTargetPool::release(RenderTarget* target)
+	{
+		for (Entry& entry : entries)
+		{
+			if (entry.target == target)
+			{
+				entry.inUse = false;
+				return;
+			}
+		}
+	}
+
+	void RenderTargetPool::endFrame(unsigned int maxUnusedFrames)
+	{
+		for (auto it = entries.begin(); it != entries.end();)
+		{
+			if (!it->inUse && ++it->unusedFrames > maxUnusedFrames)
+			{
+				RenderTarget* target = it->target;
+				glDeleteFramebuffers(1, &target->fbo);
+				glDeleteTextures(1, &target->texture);
+				if (target->depthStencilTexture != 0)
+					glDeleteTextures(1, &target->depthStencilTexture);
+				delete target;
+				it = entries.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	void RenderTargetPool::clear()
+	{
+		for (Entry& entry : entries)
+		{
+			entry.inUse = false;
+		}
+		endFrame(0);
+	}
+
+	unsigned int RenderTargetPool::getTargetCount() const
+	{
+		return (unsigned int)entries.size();
+	}
+
+	size_t RenderTargetPool::getAllocatedBytes() const
+	{
+		size_t bytes = 0;
+		for (const Entry& entry : entries)
+		{
+			bytes += entry.target->desc.getBytes();
+		}
+		return bytes;
+	}
+
+	/* RenderPassBuilder */
+	RenderPassBuilder::RenderPassBuilder(RenderGraph* graph, unsigned int pass) : graph(graph), pass(pass) {}
+
+	RenderResource RenderPassBuilder::create(const std::string& name, const RenderTargetDesc& desc)
+	{
+		RenderGraph::Resource resource;
+		resource.name = name;
+		resource.desc = desc;
+		graph->resources.push_back(resource);
+
+		RenderResource version = graph->addVersion((unsigned int)graph->resources.size() - 1, pass);
+		graph->passes[pass].writes.push_back(version);
+		return version;
+	}
+
+	RenderResource RenderPassBuilder::read(RenderResource resource)
+	{
+		graph->versions[resource].readers.push_back(pass);
+		graph->passes[pass].reads.push_back(resource);
+		return resource;
+	}
+
+	RenderResource RenderPassBuilder::write(RenderResource resource)
+	{
+		// the previous version is consumed, the new one is produced by this pass
+		graph->passes[pass].reads.push_back(resource);
+		RenderResource version = graph->addVersion(graph->versions[resource].resource, pass);
+		graph->passes[pass].writes.push_back(version);
+		return version;
+	}
+
+	void RenderPassBuilder::setSideEffect()
+	{
+		graph->passes[pass].sideEffect = true;
+	}
+
+	void RenderPassBuilder::setExecute(const ExecuteFunction& execute)
+	{
+		graph->passes[pass].execute = execute;
+	}
+
+	/* RenderGraph */
+	RenderGraph::RenderGraph(RenderTargetPool* pool, PassTimer* timer) : pool(pool), timer(timer) {}
+
+	RenderResource RenderGraph::addVersion(unsigned int resource, int producer)
+	{
+		Version version;
+		version.resource = resource;
+		version.producer = producer;
+		versions.push_back(version);
+		return (RenderResource)versions.size() - 1;
+	}
+
+	RenderResource RenderGraph::importTarget(const std::string& name, GLuint fbo, GLuint texture)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.imported = true;
+		resource.fbo = fbo;
+		resource.texture = texture;
+		resources.push_back(resource);
+		return addVersion((unsigned int)resources.size() - 1, -1);
+	}
+
+	RenderPassBuilder RenderGraph::addPass(const std::string& name)
+	{
+		Pass pass;
+		pass.name = name;
+		passes.push_back(pass);
+		return RenderPassBuilder(this, (unsigned int)passes.size() - 1);
+	}
+
+	void RenderGraph::setOutput(RenderResource resource)
+	{
+		outputs.push_back(resource);
+	}
+
+	void RenderGraph::cull()
+	{
+		std::vector<unsigned int> stack;
+		for (unsigned int i = 0; i < passes.size(); i++)
+		{
+			if (passes[i].sideEffect) stack.push_back(i);
+		}
+		for (RenderResource output : outputs)
+		{
+			if (versions[output].producer >= 0) stack.push_back(versions[output].producer);
+		}
+
+		// everything a used pass reads has to be produced
+		while (!stack.empty())
+		{
+			unsigned int pass = stack.back();
+			stack.pop_back();
+			if (passes[pass].used) continue;
+			passes[pass].used = true;
+
+			for (RenderResource read : passes[pass].reads)
+			{
+				int producer = versions[read].producer;
+				if (producer >= 0 && !passes[producer].used) stack.push_back(producer);
+			}
+		}
+
+		// readers of a version run before the pass writing the next version of the same resource
+		for (unsigned int i = 0; i < passes.size(); i++)
+		{
+			Pass& pass = passes[i];
+			if (!pass.used) continue;
+
+			for (RenderResource read : pass.reads)
+			{
+				const Version& version = versions[read];
+				if (version.producer >= 0) pass.dependencies.push_back(version.producer);
+			}
+
+			for (RenderResource write : pass.writes)
+			{
+				for (RenderResource read : pass.reads)
+				{
+					if (versions[read].resource != versions[write].resource) continue;
+					for (unsigned int reader : versions[read].readers)
+					{
+						if (reader != i && passes[reader].used) pass.dependencies.push_back(reader);
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<unsigned int> RenderGraph::sortPasses() const
+	{
+		// topological order, among the passes that are ready the one added first runs first
+		std::vector<unsigned int> order;
+		std::vector<bool> done(passes.size(), false);
+		unsigned int usedCount = 0;
+		for (const Pass& pass : passes)
+		{
+			if (pass.used) usedCount++;
+		}
+
+		while (order.size() < usedCount)
+		{
+			bool found = false;
+			for (unsigned int i = 0; i < passes.size() && !found; i++)
+			{
+				if (!passes[i].used || done[i]) continue;
+
+				bool ready = std::all_of(passes[i].dependencies.begin(), passes[i].dependencies.end(), [&](unsigned int dependency) { return done[dependency]; });
+				if (ready)
+				{
+					done[i] = true;
+					order.push_back(i);
+					found = true;
+				}
+			}
+
+			if (!found)
+			{
+				throw Exception("Render graph contains a cycle.");
+			}
+		}
+
+		return order;
+	}
+
+	void RenderGraph::execute()
+	{
+		cull();
+		std::vector<unsigned int> order = sortPasses();
+
+		// lifetime of every transient resource in executed passes
+		std::vector<int> firstUse(resources.size(), -1);
+		std::vector<int> lastUse(resources.size(), -1);
+		for (unsigned int i = 0; i < order.size(); i++)
+		{
+			const Pass& pass = passes[order[i]];
+			for (const std::vector<RenderResource>* list : { &pass.reads, &pass.writes })
+			{
+				for (RenderResource version : *list)
+				{
+					unsigned int resource = versions[version].resource;
+					if (firstUse[resource] < 0) firstUse[resource] = i;
+					lastUse[resource] = i;
+				}
+			}
+		}
+
+		executedPasses.clear();
+		if (timer) timer->beginFrame();
+		for (unsigned int i = 0; i < order.size(); i++)
+		{
+			for (unsigned int r = 0; r < resources.size(); r++)
+			{
+				if (!resources[r].imported && firstUse[r] == (int)i)
+				{
+					resources[r].target = pool->acquire(resources[r].desc);
+				}
+			}
+
+			const Pass& pass = passes[order[i]];
+			if (timer) timer->begin(pass.name);
+			if (pass.execute) pass.execute(*this);
+			if (timer) timer->end();
+			executedPasses.push_back(pass.name);
+
+			// released targets can be handed to resources created by later passes
+			for (unsigned int r = 0; r < resources.size(); r++)
+			{
+				if (!resources[r].imported && lastUse[r] == (int)i)
+				{
+					pool->release(resources[r].target);
+					resources[r].target = nullptr;
+				}
+			}
+		}
+		if (timer) timer->endFrame();
+	}
+
+	const RenderGraph::Resource& RenderGraph::getResource(RenderResource resource) const
+	{
+		return resources[versions[resource].resource];
+	}
+
+	GLuint RenderGraph::getTexture(RenderResource resource) const
+	{
+		const Resource& r = getResource(resource);
+		if (r.imported) return r.texture;
+		return r.target ? r.target->texture : 0;
+	}
+
+	GLuint RenderGraph::getFramebuffer(RenderResource resource) const
+	{
+		const Resource& r = getResource(resource);
+		if (r.imported) return r.fbo;
+		return r.target ? r.target->fbo : 0;
+	}
+
+	const RenderTargetDesc& RenderGraph::getDesc(RenderResource resource) const
+	{
+		return getResource(resource).desc;
+	}
+
+	const std::vector<std::string>& RenderGraph::getExecutedPasses() const
+	{
+		return executedPasses;
+	}
+
+	unsigned int RenderGraph::getCulledPassCount() const
+	{
+		return (unsigned int)(passes.size() - executedPasses.size());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace engine
+{
+	// size and format of a render target, targets with equal descriptions can share their textures
+	struct RenderTargetDesc
+	{
+		unsigned int width = 0;
+		unsigned int height = 0;
+		GLenum format = GL_RGBA8;
+		GLenum filter = GL_NEAREST;
+		// adds a GL_DEPTH24_STENCIL8 attachment, e.g. to blit the GBuffer depth into
+		bool depthStencil = false;
+
+		bool operator==(const RenderTargetDesc& other) const;
+		size_t getBytes() const;
+	};
+
+	struct RenderTarget
+	{
+		RenderTargetDesc desc;
+		GLuint fbo = 0;
+		GLuint texture = 0;
+		GLuint depthStencilTexture = 0;
+	};
+
+	// Owns the textures of transient render targets. A released target is handed out again to the next request with
+	// the same description, targets no pass acquired for a few frames are deleted so disabled effects free their memory.
+	class RenderTargetPool
+	{
+	public:
+		~RenderTargetPool();
+
+		RenderTarget* acquire(const RenderTargetDesc& desc);
+		void release(RenderTarget* target);
+		// deletes the targets that were not acquired during the last maxUnusedFrames frames
+		void endFrame(unsigned int maxUnusedFrames = 3);
+		void clear();
+
+		unsigned int getTargetCount() const;
+		size_t getAllocatedBytes() const;
+	private:
+		struct Entry
+		{
+			RenderTarget* target;
+			bool inUse;
+			unsigned int unusedFrames;
+		};
+
+		std::vector<Entry> entries;
+	};
+
+	// handle to one version of a graph resource, every write produces a new version
+	typedef int RenderResource;
+	const RenderResource NO_RENDER_RESOURCE = -1;
+
+	class RenderGraph;
+	class PassTimer;
+
+	// declares what a pass reads and writes and how it renders
+	class RenderPassBuilder
+	{
+	public:
+		typedef std::function<void(const RenderGraph&)> ExecuteFunction;
+
+		// a transient target written by this pass, its texture is taken from the pool only while it is alive
+		RenderResource create(const std::string& name, const RenderTargetDesc& desc);
+		RenderResource read(RenderResource resource);
+		// modifies the given version in place, the pass runs after every other pass reading that version
+		RenderResource write(RenderResource resource);
+		// keeps the pass even if no output depends on it
+		void setSideEffect();
+		// called once the graph runs, capture the resource handles by value since later writes reassign them
+		void setExecute(const ExecuteFunction& execute);
+	private:
+		friend class RenderGraph;
+		RenderPassBuilder(RenderGraph* graph, unsigned int pass);
+
+		RenderGraph* graph;
+		unsigned int pass;
+	};
+
+	// Frame graph of render passes declaring the resources they read and write. Passes no output depends on are culled,
+	// the others are ordered by their dependencies and transient targets whose lifetimes do not overlap share textures.
+	// Built anew every frame: add the passes, set the output and execute.
+	class RenderGraph
+	{
+	public:
+		// the timer, if any, measures the GPU time of every executed pass
+		explicit RenderGraph(RenderTargetPool* pool, PassTimer* timer = nullptr);
+
+		// a target owned outside the graph, e.g. the GBuffer or the default framebuffer
+		RenderResource importTarget(const std::string& name, GLuint fbo, GLuint texture);
+		RenderPassBuilder addPass(const std::string& name);
+		void setOutput(RenderResource resource);
+
+		// culls, orders and runs the passes, transient targets are acquired before their first and released after their last use
+		void execute();
+
+		GLuint getTexture(RenderResource resource) const;
+		GLuint getFramebuffer(RenderResource resource) const;
+		const RenderTargetDesc& getDesc(RenderResource resource) const;
+
+		// names of the passes in the order of the last execution
+		const std::vector<std::string>& getExecutedPasses() const;
+		unsigned int getCulledPassCount() const;
+	private:
+		friend class RenderPassBuilder;
+
+		struct Resource
+		{
+			std::string name;
+			RenderTargetDesc desc;
+			bool imported = false;
+			GLuint fbo = 0;
+			GLuint texture = 0;
+			RenderTarget* target = nullptr;
+		};
+
+		struct Version
+		{
+			unsigned int resource;
+			int producer = -1;
+			std::vector<unsigned int> readers;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			RenderPassBuilder::ExecuteFunction execute;
+			std::vector<RenderResource> reads;
+			std::vector<RenderResource> writes;
+			std::vector<unsigned int> dependencies;
+			bool sideEffect = false;
+			bool used = false;
+		};
+
+		RenderResource addVersion(unsigned int resource, int producer);
+		const Resource& getResource(RenderResource resource) const;
+		void cull();
+		std::vector<unsigned int> sortPasses() const;
+
+		RenderTargetPool* pool;
+		PassTimer* timer;
+		std::vector<Resource> resources;
+		std::vector<Version> versions;
+		std::vector<Pass> passes;
+		std::vector<RenderResource> outputs;
+		std::vector<std::string> executedPasses;
+	};
+}
\ No newline at end of file
@@ -12,9 +12,9 @@ namespace engine
 		delete root;
 	}
 
-	void SceneGraph::draw()
+	void SceneGraph::draw(ShaderProgram* programOverride)
 	{
-		root->draw();
+		root->draw(programOverride);
 	}
 
 	SceneNode* SceneGraph::getRoot()
@@ -53,6 +53,11 @@ namespace engine
 		this->matrix = matrix;
 	}
 
+	IDrawable* SceneNode::getDrawable()
+	{
+		return drawable;
+	}
+
 	void SceneNode::setDrawable(IDrawable* drawable)
 	{
 		this->drawable = drawable;
@@ -90,14 +95,14 @@ namespace engine
 		return nodes;
 	}
 
-	void SceneNode::draw()
+	void SceneNode::draw(ShaderProgram* programOverride)
 	{
 		if (callback != nullptr)
 		{
 			callback->beforeDraw(this);
 		}
 
-		ShaderProgram* program = getActiveShaderProgram();
+		ShaderProgram* program = programOverride ? programOverride : getActiveShaderProgram();
 		program->use();
 		if (drawable != nullptr)
 		{
@@ -113,7 +118,7 @@ namespace engine
 
 		for (SceneNode* sn : nodes)
 		{
-			sn->draw();
+			sn->draw(programOverride);
 		}
 
 		if (callback != nullptr)
@@ -20,7 +20,9 @@ namespace engine
 		~SceneGraph();
 
 		SceneNode* getRoot();
-		void draw();
+
+		// draws every node with programOverride instead of the node's own program if given
+		void draw(ShaderProgram* programOverride = nullptr);
 	private:
 		SceneNode* root;
 	};
@@ -46,14 +48,16 @@ namespace engine
 		Matrix4 getMatrix();
 		void setMatrix(Matrix4);
 
+		IDrawable* getDrawable();
 		void setDrawable(IDrawable*);
 		void addNode(SceneNode*);
 		SceneNode* createNode();
 		void removeNode(SceneNode*);
 		void clearNodes();
 		std::vector<SceneNode*> getNodes();
-		void draw();
+		void draw(ShaderProgram* programOverride = nullptr);
 		void setCallback(ISceneNodeCallback*);
+		Matrix4 getModelMatrix();
 	private:
 		std::vector<SceneNode*> nodes;
 		SceneNode* parent = nullptr;
@@ -61,7 +65,6 @@ namespace engine
 		Matrix4 matrix;
 		IDrawable* drawable = nullptr;
 		ISceneNodeCallback* callback = nullptr;
-		Matrix4 getModelMatrix();
 		ShaderProgram* getActiveShaderProgram();
 	};
 }
@@ -0,0 +1,97 @@
+#include "screenviewport.h"
+
+namespace engine
+{
+	ScreenViewport::ScreenViewport(unsigned int width, unsigned int height) : width(width), height(height), outputWidth(width), outputHeight(height)
+	{
+		targetWidth = roundToBucket(width);
+		targetHeight = roundToBucket(height);
+
+		// viewport size and viewport size / target size, std140 packs both vec2 into 16 bytes
+		glGenBuffers(1, &uboId);
+		glBindBuffer(GL_UNIFORM_BUFFER, uboId);
+		glBufferData(GL_UNIFORM_BUFFER, 4 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, UBO_BP, uboId);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		upload();
+	}
+
+	ScreenViewport::~ScreenViewport() { glDeleteBuffers(1, &uboId); }
+
+	unsigned int ScreenViewport::roundToBucket(unsigned int size)
+	{
+		// a minimized window reports a size of zero, targets keep at least one bucket
+		if (size == 0) return BUCKET_SIZE;
+		return (size + BUCKET_SIZE - 1) / BUCKET_SIZE * BUCKET_SIZE;
+	}
+
+	bool ScreenViewport::resize(unsigned int newWidth, unsigned int newHeight)
+	{
+		outputWidth = newWidth;
+		outputHeight = newHeight;
+		settleTime = 0.0;
+
+		// the targets fit the window, whatever the scale
+		bool exceeded = outputWidth > targetWidth || outputHeight > targetHeight;
+		if (exceeded)
+		{
+			targetWidth = roundToBucket(outputWidth);
+			targetHeight = roundToBucket(outputHeight);
+		}
+		setScale(scale);
+		return exceeded;
+	}
+
+	void ScreenViewport::setScale(float newScale)
+	{
+		scale = newScale > 1.f ? 1.f : newScale;
+		width = (unsigned int)(outputWidth * scale + 0.5f);
+		height = (unsigned int)(outputHeight * scale + 0.5f);
+		// a scaled window keeps at least a pixel, a minimized one stays empty
+		if (width == 0 && outputWidth != 0) width = 1;
+		if (height == 0 && outputHeight != 0) height = 1;
+		upload();
+	}
+
+	bool ScreenViewport::update(double elapsedSecs)
+	{
+		if (settleTime < 0.0) return false;
+
+		settleTime += elapsedSecs;
+		if (settleTime < VIEWPORT_SETTLE_SECONDS) return false;
+		settleTime = -1.0;
+
+		// only a window that got smaller leaves buckets unused
+		unsigned int fittingWidth = roundToBucket(outputWidth);
+		unsigned int fittingHeight = roundToBucket(outputHeight);
+		if (fittingWidth == targetWidth && fittingHeight == targetHeight) return false;
+
+		targetWidth = fittingWidth;
+		targetHeight = fittingHeight;
+		upload();
+		return true;
+	}
+
+	void ScreenViewport::apply(unsigned int level) const
+	{
+		// rounded up, the last row and column of a downscaled target are partly outside the window
+		unsigned int scale = 1u << level;
+		glViewport(0, 0, (width + scale - 1) / scale, (height + scale - 1) / scale);
+	}
+
+	void ScreenViewport::upload()
+	{
+		float data[4] = { (float)width, (float)height, width / (float)targetWidth, height / (float)targetHeight };
+		glBindBuffer(GL_UNIFORM_BUFFER, uboId);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	float ScreenViewport::getScale() const { return scale; }
+	unsigned int ScreenViewport::getWidth() const { return width; }
+	unsigned int ScreenViewport::getHeight() const { return height; }
+	unsigned int ScreenViewport::getOutputWidth() const { return outputWidth; }
+	unsigned int ScreenViewport::getOutputHeight() const { return outputHeight; }
+	unsigned int ScreenViewport::getTargetWidth() const { return targetWidth; }
+	unsigned int ScreenViewport::getTargetHeight() const { return targetHeight; }
+}
\ No newline at end of file
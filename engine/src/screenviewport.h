@@ -0,0 +1,60 @@
+#pragma once
+
+#include <GL/glew.h>
+
+namespace engine
+{
+	// seconds without a resize event before the targets shrink to the bucket of the window
+	const double VIEWPORT_SETTLE_SECONDS = 0.5;
+
+	// Size of the screen sized render targets and of the viewport rendered into them. Targets are allocated in buckets
+	// larger than the window and only their bottom left viewport rectangle is rendered, so dragging a window border only
+	// reallocates when the window outgrows its bucket. Once resizing settled the targets shrink to fit the window again.
+	// The rendered rectangle can be scaled down from the window for dynamic resolution, an upscale pass then fills the
+	// window, changing the scale never reallocates the targets.
+	// Shaders read the viewport from the ScreenViewport uniform block declared in viewport.glsl.
+	class ScreenViewport
+	{
+	public:
+		// target sizes are multiples of it, so targets downscaled by up to 2^8 keep the texture coordinates of the viewport
+		static const unsigned int BUCKET_SIZE = 256;
+		// uniform buffer binding point of the ScreenViewport block, fixed in the shaders
+		static const GLuint UBO_BP = 1;
+
+		ScreenViewport(unsigned int width, unsigned int height);
+		~ScreenViewport();
+
+		// returns true if the targets are too small for the new window size and have to be reallocated right away
+		bool resize(unsigned int width, unsigned int height);
+		// returns true once resizing settled and the targets should be reallocated at the bucket of the window
+		bool update(double elapsedSecs);
+
+		// scale of the rendered rectangle relative to the window, at most 1
+		void setScale(float scale);
+		float getScale() const;
+
+		// sets the GL viewport to the rendered rectangle of a target downscaled by 2^level from the screen targets
+		void apply(unsigned int level = 0) const;
+
+		// rendered rectangle, the window size times the scale
+		unsigned int getWidth() const;
+		unsigned int getHeight() const;
+		// the window size
+		unsigned int getOutputWidth() const;
+		unsigned int getOutputHeight() const;
+		// size to allocate screen sized targets with
+		unsigned int getTargetWidth() const;
+		unsigned int getTargetHeight() const;
+	private:
+		static unsigned int roundToBucket(unsigned int size);
+		void upload();
+
+		GLuint uboId = 0;
+		unsigned int width = 0, height = 0;
+		unsigned int outputWidth = 0, outputHeight = 0;
+		float scale = 1.f;
+		unsigned int targetWidth = 0, targetHeight = 0;
+		// time since the last resize, negative while the size is settled
+		double settleTime = -1.0;
+	};
+}
\ No newline at end of file
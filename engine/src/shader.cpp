@@ -1,6 +1,7 @@
 #include "shader.h"
 
 #include <fstream>
+#include <algorithm>
 
 #include <stdexcept>
 
@@ -17,44 +18,116 @@ namespace engine
 		return content;
 	}
 
-	void ShaderProgram::init(const char* vertexShaderFilename, const char* fragmentShaderFilename)
+	std::string directoryOf(const std::string& filename)
 	{
-		int  success;
-		char infoLog[512];
+		size_t separator = filename.find_last_of("/\\");
+		return separator == std::string::npos ? "" : filename.substr(0, separator + 1);
+	}
 
-		std::string vertexShaderSource = readStringFromFile(vertexShaderFilename);
-		std::string fragmentShaderSource = readStringFromFile(fragmentShaderFilename);
+	// resolves #include "file" relative to the including file, every file is only included once
+	std::string resolveIncludes(const std::string& filename, std::vector<std::string>& includedFiles)
+	{
+		includedFiles.push_back(filename);
 
-		const char* vertexShaderSourceC = vertexShaderSource.c_str();
-		const char* fragmentShaderSourceC = fragmentShaderSource.c_str();
+		std::string source = readStringFromFile(filename.c_str());
+		std::string result;
+
+		size_t lineStart = 0;
+		while (lineStart < source.size())
+		{
+			size_t lineEnd = source.find('\n', lineStart);
+			if (lineEnd == std::string::npos) lineEnd = source.size();
+			std::string line = source.substr(lineStart, lineEnd - lineStart);
+
+			size_t directive = line.find_first_not_of(" \t");
+			if (directive != std::string::npos && line.compare(directive, 8, "#include") == 0)
+			{
+				size_t open = line.find('"', directive);
+				size_t close = line.find('"', open + 1);
+				if (open == std::string::npos || close == std::string::npos)
+				{
+					throw ShaderCompilationException(("Malformed include in " + filename + ": " + line).c_str());
+				}
+
+				std::string includeFilename = directoryOf(filename) + line.substr(open + 1, close - open - 1);
+				if (std::find(includedFiles.begin(), includedFiles.end(), includeFilename) == includedFiles.end())
+				{
+					result += resolveIncludes(includeFilename, includedFiles);
+				}
+			}
+			else
+			{
+				result += line;
+			}
+			result += '\n';
+			lineStart = lineEnd + 1;
+		}
+		return result;
+	}
 
-		vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertexShaderId, 1, &vertexShaderSourceC, 0);
-		glCompileShader(vertexShaderId);
+	std::string loadShaderSource(const char* filename, const std::vector<std::string>& defines)
+	{
+		std::vector<std::string> includedFiles;
+		std::string source = resolveIncludes(filename, includedFiles);
 
-		glGetShaderiv(vertexShaderId, GL_COMPILE_STATUS, &success);
-		if (!success)
+		if (!defines.empty())
 		{
-			glGetShaderInfoLog(vertexShaderId, 512, NULL, infoLog);
-			throw ShaderCompilationException(infoLog);
+			// #version has to stay the first statement
+			size_t versionEnd = 0;
+			if (source.compare(0, 8, "#version") == 0)
+			{
+				versionEnd = source.find('\n') + 1;
+			}
+
+			std::string defineBlock;
+			for (const std::string& define : defines)
+			{
+				defineBlock += "#define " + define + "\n";
+			}
+			source.insert(versionEnd, defineBlock);
 		}
+		return source;
+	}
 
-		fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragmentShaderId, 1, &fragmentShaderSourceC, 0);
-		glCompileShader(fragmentShaderId);
+	GLuint compileShader(GLenum type, const std::string& source)
+	{
+		int  success;
+		char infoLog[512];
+
+		const char* sourceC = source.c_str();
 
-		glGetShaderiv(fragmentShaderId, GL_COMPILE_STATUS, &success);
+		GLuint shaderId = glCreateShader(type);
+		glShaderSource(shaderId, 1, &sourceC, 0);
+		glCompileShader(shaderId);
+
+		glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
 		if (!success)
 		{
-			glGetShaderInfoLog(fragmentShaderId, 512, NULL, infoLog);
+			glGetShaderInfoLog(shaderId, 512, NULL, infoLog);
+			glDeleteShader(shaderId);
 			throw ShaderCompilationException(infoLog);
 		}
+		return shaderId;
+	}
+
+	void ShaderProgram::init(const char* vertexShaderFilename, const char* fragmentShaderFilename, const std::vector<std::string>& defines)
+	{
+		vertexShaderId = compileShader(GL_VERTEX_SHADER, loadShaderSource(vertexShaderFilename, defines));
+		fragmentShaderId = compileShader(GL_FRAGMENT_SHADER, loadShaderSource(fragmentShaderFilename, defines));
 
 		programId = glCreateProgram();
 		glAttachShader(programId, vertexShaderId);
 		glAttachShader(programId, fragmentShaderId);
 	}
 
+	void ShaderProgram::initCompute(const char* computeShaderFilename, const std::vector<std::string>& defines)
+	{
+		computeShaderId = compileShader(GL_COMPUTE_SHADER, loadShaderSource(computeShaderFilename, defines));
+
+		programId = glCreateProgram();
+		glAttachShader(programId, computeShaderId);
+	}
+
 	void ShaderProgram::bindAttribLocation(GLuint id, const char* str)
 	{
 		glBindAttribLocation(programId, id, str);
@@ -67,10 +140,13 @@ namespace engine
 
 		glLinkProgram(programId);
 
-		glDetachShader(programId, vertexShaderId);
-		glDeleteShader(vertexShaderId);
-		glDetachShader(programId, fragmentShaderId);
-		glDeleteShader(fragmentShaderId);
+		for (GLuint* shaderId : { &vertexShaderId, &fragmentShaderId, &computeShaderId })
+		{
+			if (*shaderId == 0) continue;
+			glDetachShader(programId, *shaderId);
+			glDeleteShader(*shaderId);
+			*shaderId = 0;
+		}
 
 		glGetProgramiv(programId, GL_LINK_STATUS, &success);
 		if (!success)
@@ -97,7 +173,7 @@ namespace engine
 		glUniform3fv(location, 1, (GLfloat*)&vector);
 	}
 
-	void ShaderProgram::setUniform(const char* name, const std::vector<Vector3> vectors)
+	void ShaderProgram::setUniform(const char* name, const std::vector<Vector3>& vectors)
 	{
 		GLuint location = glGetUniformLocation(programId, name);
 		glUniform3fv(location, (GLsizei)vectors.size(), (GLfloat*)&vectors[0]);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <string>
 
 #include "matrix.h"
 #include "exceptions.h"
@@ -15,13 +16,15 @@ namespace engine
 		ShaderProgram() = default;
 		~ShaderProgram();
 
-		void init(const char*, const char*);
+		// defines are inserted after the #version line, e.g. "TILED_LIGHTING" or "TILE_SIZE 16"
+		void init(const char*, const char*, const std::vector<std::string>& defines = {});
+		void initCompute(const char*, const std::vector<std::string>& defines = {});
 		void bindAttribLocation(GLuint, const char*);
 		void link();
 		GLuint getUniformLocation(const char*);
 		void setUniform(const char*, const Vector2&);
 		void setUniform(const char*, const Vector3&);
-		void setUniform(const char*, const std::vector<Vector3>);
+		void setUniform(const char*, const std::vector<Vector3>&);
 		void setUniform(const char*, const Vector4&);
 		void setUniform(const char*, const Matrix3&);
 		void setUniform(const char*, const Matrix4&);
@@ -32,8 +35,8 @@ namespace engine
 		void use();
 		void unuse();
 	private:
-		GLuint programId;
-		GLuint vertexShaderId, fragmentShaderId;
+		GLuint programId = 0;
+		GLuint vertexShaderId = 0, fragmentShaderId = 0, computeShaderId = 0;
 	};
 
 }
@@ -0,0 +1,51 @@
+#include "shadervariantcache.h"
+
+namespace engine
+{
+	ShaderVariantCache::ShaderVariantCache(const std::string& vertexFile, const std::string& fragmentFile, const std::vector<std::string>& features,
+		const std::vector<std::string>& defines, const std::function<void(ShaderProgram*)>& setup)
+		: vertexFile(vertexFile), fragmentFile(fragmentFile), features(features), defines(defines), setup(setup)
+	{
+	}
+
+	ShaderVariantCache::~ShaderVariantCache()
+	{
+		for (auto& variant : variants)
+		{
+			delete variant.second;
+		}
+	}
+
+	ShaderProgram* ShaderVariantCache::get(unsigned int featureMask)
+	{
+		auto found = variants.find(featureMask);
+		if (found != variants.end()) return found->second;
+
+		std::vector<std::string> variantDefines = defines;
+		for (unsigned int i = 0; i < features.size(); i++)
+		{
+			if (featureMask & (1u << i)) variantDefines.push_back(features[i]);
+		}
+
+		ShaderProgram* program = new ShaderProgram();
+		try
+		{
+			program->init(vertexFile.c_str(), fragmentFile.c_str(), variantDefines);
+			program->link();
+		}
+		catch (...)
+		{
+			delete program;
+			throw;
+		}
+		if (setup) setup(program);
+
+		variants[featureMask] = program;
+		return program;
+	}
+
+	unsigned int ShaderVariantCache::getVariantCount() const
+	{
+		return (unsigned int)variants.size();
+	}
+}
\ No newline at end of file
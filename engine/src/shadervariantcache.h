@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "shader.h"
+
+namespace engine
+{
+	// Programs compiled from the same sources for different combinations of optional features, so a pass can run a
+	// shader that contains exactly the features in use instead of branching over all of them. Every feature is a define
+	// selected by one bit of a mask; a combination is compiled and set up the first time it is requested.
+	class ShaderVariantCache
+	{
+	public:
+		// setup is called once per variant after linking, e.g. to set the texture units of its samplers
+		ShaderVariantCache(const std::string& vertexFile, const std::string& fragmentFile, const std::vector<std::string>& features,
+			const std::vector<std::string>& defines = {}, const std::function<void(ShaderProgram*)>& setup = nullptr);
+		~ShaderVariantCache();
+
+		// the program with the define of every feature whose bit is set in the mask
+		ShaderProgram* get(unsigned int featureMask);
+		unsigned int getVariantCount() const;
+	private:
+		std::string vertexFile, fragmentFile;
+		std::vector<std::string> features;
+		std::vector<std::string> defines;
+		std::function<void(ShaderProgram*)> setup;
+		std::map<unsigned int, ShaderProgram*> variants;
+	};
+}
\ No newline at end of file
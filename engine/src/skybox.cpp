@@ -36,6 +36,13 @@ namespace engine {
 		program->unuse();
 	}
 
+	void Skybox::setBloomThreshold(float threshold)
+	{
+		program->use();
+		program->setUniform("bloomThreshold", threshold);
+		program->unuse();
+	}
+
 	TextureCubemap* Skybox::getCubemap() const
 	{
 		return (TextureCubemap*)textureInfo->texture;
@@ -13,6 +13,8 @@ namespace engine {
 
 		void enableToneMapping();
 		void disableToneMapping();
+		// threshold of the bright part written for bloom
+		void setBloomThreshold(float threshold);
 
 		TextureCubemap* getCubemap() const;
 		void setCubemap(TextureCubemap* cubemap);
@@ -0,0 +1,418 @@
+#include "softwareocclusion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OCCLUSION_USE_SSE
+#include <immintrin.h>
+#endif
+
+namespace engine
+{
+	namespace
+	{
+		const int TILE_COUNT = SoftwareOcclusion::TILES_X * SoftwareOcclusion::TILES_Y;
+		// the buffer is too small to keep more workers busy
+		const unsigned int MAX_THREADS = 8;
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	SoftwareOcclusion::SoftwareOcclusion() : nextTile(0)
+	{
+		unsigned int threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), MAX_THREADS));
+		bins.resize(threadCount * TILE_COUNT);
+		depth.assign(WIDTH * HEIGHT, 1.f);
+		statistics.threads = threadCount;
+
+		// the calling thread is worker 0
+		for (unsigned int i = 1; i < threadCount; i++)
+		{
+			workers.emplace_back(&SoftwareOcclusion::workerLoop, this, i);
+		}
+	}
+
+	SoftwareOcclusion::~SoftwareOcclusion()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wakeCondition.notify_all();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void SoftwareOcclusion::addOccluder(SceneNode* node)
+	{
+		occluderNodes.push_back(node);
+	}
+
+	const SoftwareOcclusion::Statistics& SoftwareOcclusion::getStatistics() const
+	{
+		return statistics;
+	}
+
+	void SoftwareOcclusion::runOnWorkers(const std::function<void(unsigned int)>& job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			this->job = &job;
+			pendingWorkers = (unsigned int)workers.size();
+			generation++;
+		}
+		wakeCondition.notify_all();
+		job(0);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCondition.wait(lock, [this] { return pendingWorkers == 0; });
+	}
+
+	void SoftwareOcclusion::workerLoop(unsigned int worker)
+	{
+		unsigned int lastGeneration = 0;
+		while (true)
+		{
+			const std::function<void(unsigned int)>* currentJob;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeCondition.wait(lock, [&] { return stopping || generation != lastGeneration; });
+				if (stopping) return;
+				lastGeneration = generation;
+				currentJob = job;
+			}
+
+			(*currentJob)(worker);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--pendingWorkers == 0) doneCondition.notify_one();
+		}
+	}
+
+	bool SoftwareOcclusion::isOccluder(SceneNode* node) const
+	{
+		return std::find(occluderNodes.begin(), occluderNodes.end(), node) != occluderNodes.end();
+	}
+
+	// alpha tested meshes have holes the rasterizer does not know about
+	bool SoftwareOcclusion::isOpaque(Mesh* mesh)
+	{
+		Material* material = mesh->getMaterial();
+		return material == nullptr || !(material->alphaTest && material->useAlbedoMap && material->albedoMap);
+	}
+
+	void SoftwareOcclusion::collectObjects(SceneNode* node, ShaderProgram* program)
+	{
+		// nodes without a program of their own draw with the one of their parent
+		if (node->getShaderProgram() != nullptr) program = node->getShaderProgram();
+
+		IDrawable* drawable = node->getDrawable();
+		if (drawable != nullptr)
+		{
+			Matrix4 modelMatrix = node->getModelMatrix();
+			Matrix3 normalMatrix = Matrix3(modelMatrix).inversed().transposed();
+			bool occluderNode = isOccluder(node);
+			for (Mesh* mesh : drawable->getMeshes())
+			{
+				bool occluder = occluderNode && isOpaque(mesh);
+				objects.push_back({ mesh, program, modelMatrix, normalMatrix, occluder });
+				if (occluder)
+				{
+					occluderMeshes.push_back({ mesh, viewProjection * modelMatrix, occluderTriangles });
+					occluderTriangles += mesh->getIndices().size() / 3;
+				}
+			}
+		}
+
+		for (SceneNode* child : node->getNodes())
+		{
+			collectObjects(child, program);
+		}
+	}
+
+	void SoftwareOcclusion::cull(SceneNode* root, const Matrix4& viewProjection)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		this->viewProjection = viewProjection;
+		objects.clear();
+		visibleObjects.clear();
+		occluderMeshes.clear();
+		occluderTriangles = 0;
+		collectObjects(root, nullptr);
+
+		// every worker clips and bins an even share of the triangles into bins of its own
+		for (std::vector<Triangle>& bin : bins)
+		{
+			bin.clear();
+		}
+		size_t threadCount = workers.size() + 1;
+		runOnWorkers([&](unsigned int worker)
+		{
+			setupTriangles(worker, occluderTriangles * worker / threadCount, occluderTriangles * (worker + 1) / threadCount);
+		});
+		statistics.setupMilliseconds = millisecondsSince(start);
+
+		// then the workers take whole tiles, so no pixel is written by two of them
+		start = std::chrono::steady_clock::now();
+		std::fill(depth.begin(), depth.end(), 1.f);
+		nextTile = 0;
+		runOnWorkers([&](unsigned int)
+		{
+			for (int tile = nextTile++; tile < TILE_COUNT; tile = nextTile++)
+			{
+				rasterizeTile(tile);
+			}
+		});
+		statistics.rasterMilliseconds = millisecondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		statistics.outsideFrustum = 0;
+		statistics.occluded = 0;
+		for (const Object& object : objects)
+		{
+			Matrix4 modelViewProjection = viewProjection * object.modelMatrix;
+			Vector3 boundsMin = object.mesh->getBoundsMin();
+			Vector3 boundsMax = object.mesh->getBoundsMax();
+			Vector4 corners[8];
+			for (int i = 0; i < 8; i++)
+			{
+				corners[i] = modelViewProjection * Vector4(i & 1 ? boundsMax.x : boundsMin.x, i & 2 ? boundsMax.y : boundsMin.y, i & 4 ? boundsMax.z : boundsMin.z, 1.f);
+			}
+
+			if (!insideFrustum(corners)) statistics.outsideFrustum++;
+			else if (!object.occluder && isOccluded(corners)) statistics.occluded++;
+			else visibleObjects.push_back(&object);
+		}
+		statistics.testMilliseconds = millisecondsSince(start);
+		statistics.objects = (unsigned int)objects.size();
+		statistics.occluderTriangles = (unsigned int)occluderTriangles;
+	}
+
+	void SoftwareOcclusion::draw(ShaderProgram* programOverride)
+	{
+		for (const Object* object : visibleObjects)
+		{
+			ShaderProgram* program = programOverride ? programOverride : object->program;
+			program->use();
+			program->setUniform("ModelMatrix", object->modelMatrix);
+			program->setUniform("NormalMatrix", object->normalMatrix);
+			object->mesh->draw(program);
+			program->unuse();
+		}
+	}
+
+	void SoftwareOcclusion::setupTriangles(unsigned int worker, size_t begin, size_t end)
+	{
+		if (begin >= end) return;
+
+		// the last mesh starting at or before the first triangle of the share
+		std::vector<OccluderMesh>::const_iterator occluder = std::upper_bound(occluderMeshes.cbegin(), occluderMeshes.cend(), begin,
+			[](size_t triangle, const OccluderMesh& mesh) { return triangle < mesh.firstTriangle; }) - 1;
+		for (size_t triangle = begin; triangle < end; ++occluder)
+		{
+			const std::vector<Vertex>& vertices = occluder->mesh->getVertices();
+			const std::vector<GLuint>& indices = occluder->mesh->getIndices();
+			size_t meshEnd = std::min(end, occluder->firstTriangle + indices.size() / 3);
+			for (; triangle < meshEnd; triangle++)
+			{
+				size_t index = (triangle - occluder->firstTriangle) * 3;
+				Vector4 clip[3];
+				for (int i = 0; i < 3; i++)
+				{
+					const Vector3& position = vertices[indices[index + i]].position;
+					clip[i] = occluder->modelViewProjection * Vector4(position.x, position.y, position.z, 1.f);
+				}
+				binTriangle(worker, clip);
+			}
+		}
+	}
+
+	void SoftwareOcclusion::binTriangle(unsigned int worker, const Vector4* clip)
+	{
+		// outside the same side or the far plane
+		if ((clip[0].x < -clip[0].w && clip[1].x < -clip[1].w && clip[2].x < -clip[2].w) ||
+			(clip[0].x > clip[0].w && clip[1].x > clip[1].w && clip[2].x > clip[2].w) ||
+			(clip[0].y < -clip[0].w && clip[1].y < -clip[1].w && clip[2].y < -clip[2].w) ||
+			(clip[0].y > clip[0].w && clip[1].y > clip[1].w && clip[2].y > clip[2].w) ||
+			(clip[0].z > clip[0].w && clip[1].z > clip[1].w && clip[2].z > clip[2].w))
+		{
+			return;
+		}
+
+		// clipped to the near plane the triangle becomes a polygon of up to four vertices
+		Vector4 polygon[4];
+		int count = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			const Vector4& a = clip[i];
+			const Vector4& b = clip[(i + 1) % 3];
+			float distanceA = a.z + a.w, distanceB = b.z + b.w;
+			if (distanceA >= 0.f) polygon[count++] = a;
+			if ((distanceA >= 0.f) != (distanceB >= 0.f))
+			{
+				Vector4 intersection = b;
+				intersection -= a;
+				intersection *= distanceA / (distanceA - distanceB);
+				intersection += a;
+				polygon[count++] = intersection;
+			}
+		}
+		if (count < 3) return;
+
+		float x[4], y[4], z[4];
+		for (int i = 0; i < count; i++)
+		{
+			x[i] = (polygon[i].x / polygon[i].w * 0.5f + 0.5f) * WIDTH;
+			y[i] = (polygon[i].y / polygon[i].w * 0.5f + 0.5f) * HEIGHT;
+			z[i] = polygon[i].z / polygon[i].w * 0.5f + 0.5f;
+		}
+
+		for (int i = 1; i + 1 < count; i++)
+		{
+			// both windings are rasterized, only the depth matters
+			int v1 = i, v2 = i + 1;
+			float area = (x[v1] - x[0]) * (y[v2] - y[0]) - (x[v2] - x[0]) * (y[v1] - y[0]);
+			if (area == 0.f) continue;
+			if (area < 0.f) std::swap(v1, v2);
+			Triangle triangle = { { x[0], x[v1], x[v2] }, { y[0], y[v1], y[v2] }, { z[0], z[v1], z[v2] } };
+
+			int minX = std::max(0, (int)std::floor(std::min({ x[0], x[v1], x[v2] })));
+			int maxX = std::min(WIDTH - 1, (int)std::floor(std::max({ x[0], x[v1], x[v2] })));
+			int minY = std::max(0, (int)std::floor(std::min({ y[0], y[v1], y[v2] })));
+			int maxY = std::min(HEIGHT - 1, (int)std::floor(std::max({ y[0], y[v1], y[v2] })));
+			for (int tileY = minY / TILE_SIZE; tileY <= maxY / TILE_SIZE && minX <= maxX; tileY++)
+			{
+				for (int tileX = minX / TILE_SIZE; tileX <= maxX / TILE_SIZE; tileX++)
+				{
+					bins[worker * TILE_COUNT + tileY * TILES_X + tileX].push_back(triangle);
+				}
+			}
+		}
+	}
+
+	void SoftwareOcclusion::rasterizeTile(int tile)
+	{
+		int tileX = tile % TILES_X, tileY = tile / TILES_X;
+		for (size_t worker = 0; worker <= workers.size(); worker++)
+		{
+			for (const Triangle& triangle : bins[worker * TILE_COUNT + tile])
+			{
+				rasterizeTriangle(triangle, tileX, tileY);
+			}
+		}
+	}
+
+	void SoftwareOcclusion::rasterizeTriangle(const Triangle& t, int tileX, int tileY)
+	{
+		// edge functions a * x + b * y + c, not negative inside the counterclockwise triangle
+		float a[3], b[3], c[3];
+		for (int i = 0; i < 3; i++)
+		{
+			int j = (i + 1) % 3;
+			a[i] = t.y[i] - t.y[j];
+			b[i] = t.x[j] - t.x[i];
+			c[i] = -a[i] * t.x[i] - b[i] * t.y[i];
+		}
+
+		// the depth plane, raised to the farthest depth it reaches inside a pixel
+		float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+		float dzdx = ((t.z[1] - t.z[0]) * (t.y[2] - t.y[0]) - (t.z[2] - t.z[0]) * (t.y[1] - t.y[0])) / area;
+		float dzdy = ((t.z[2] - t.z[0]) * (t.x[1] - t.x[0]) - (t.z[1] - t.z[0]) * (t.x[2] - t.x[0])) / area;
+		float z0 = t.z[0] - dzdx * t.x[0] - dzdy * t.y[0] + 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+
+		// the pixels of the tile inside the bounds of the triangle, in aligned groups of four
+		int minX = std::max(tileX * TILE_SIZE, (int)std::floor(std::min({ t.x[0], t.x[1], t.x[2] }))) & ~3;
+		int maxX = std::min(tileX * TILE_SIZE + TILE_SIZE - 1, (int)std::floor(std::max({ t.x[0], t.x[1], t.x[2] })));
+		int minY = std::max(tileY * TILE_SIZE, (int)std::floor(std::min({ t.y[0], t.y[1], t.y[2] })));
+		int maxY = std::min(tileY * TILE_SIZE + TILE_SIZE - 1, (int)std::floor(std::max({ t.y[0], t.y[1], t.y[2] })));
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float centerY = y + 0.5f;
+			float* row = &depth[y * WIDTH];
+#ifdef OCCLUSION_USE_SSE
+			const __m128 zero = _mm_setzero_ps();
+			__m128 rowEdge0 = _mm_set1_ps(b[0] * centerY + c[0]);
+			__m128 rowEdge1 = _mm_set1_ps(b[1] * centerY + c[1]);
+			__m128 rowEdge2 = _mm_set1_ps(b[2] * centerY + c[2]);
+			__m128 rowDepth = _mm_set1_ps(dzdy * centerY + z0);
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				__m128 centerX = _mm_add_ps(_mm_set1_ps(x + 0.5f), _mm_setr_ps(0.f, 1.f, 2.f, 3.f));
+				__m128 inside = _mm_and_ps(_mm_and_ps(
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), centerX), rowEdge0), zero),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), centerX), rowEdge1), zero)),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), centerX), rowEdge2), zero));
+				if (_mm_movemask_ps(inside) == 0) continue;
+
+				__m128 pixelDepth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), centerX), rowDepth);
+				__m128 current = _mm_loadu_ps(row + x);
+				__m128 closest = _mm_min_ps(current, pixelDepth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, current)));
+			}
+#else
+			for (int x = minX; x <= maxX; x++)
+			{
+				float centerX = x + 0.5f;
+				if (a[0] * centerX + b[0] * centerY + c[0] >= 0.f && a[1] * centerX + b[1] * centerY + c[1] >= 0.f && a[2] * centerX + b[2] * centerY + c[2] >= 0.f)
+				{
+					row[x] = std::min(row[x], dzdx * centerX + dzdy * centerY + z0);
+				}
+			}
+#endif
+		}
+	}
+
+	bool SoftwareOcclusion::insideFrustum(const Vector4* corners) const
+	{
+		// outside if all corners are outside the same clip plane
+		int below[3] = {}, above[3] = {};
+		for (int i = 0; i < 8; i++)
+		{
+			const Vector4& c = corners[i];
+			below[0] += c.x < -c.w; below[1] += c.y < -c.w; below[2] += c.z < -c.w;
+			above[0] += c.x > c.w; above[1] += c.y > c.w; above[2] += c.z > c.w;
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (below[axis] == 8 || above[axis] == 8) return false;
+		}
+		return true;
+	}
+
+	bool SoftwareOcclusion::isOccluded(const Vector4* corners) const
+	{
+		float minX = (float)WIDTH, maxX = 0.f, minY = (float)HEIGHT, maxY = 0.f;
+		float closestDepth = 1.f;
+		for (int i = 0; i < 8; i++)
+		{
+			const Vector4& c = corners[i];
+			// boxes reaching in front of the near plane have no screen rectangle to test
+			if (c.w <= 0.f || c.z < -c.w) return false;
+			float x = (c.x / c.w * 0.5f + 0.5f) * WIDTH;
+			float y = (c.y / c.w * 0.5f + 0.5f) * HEIGHT;
+			minX = std::min(minX, x); maxX = std::max(maxX, x);
+			minY = std::min(minY, y); maxY = std::max(maxY, y);
+			closestDepth = std::min(closestDepth, c.z / c.w * 0.5f + 0.5f);
+		}
+
+		// every pixel the rectangle touches has to be covered by an occluder in front of the box
+		int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(WIDTH - 1, (int)std::floor(maxX));
+		int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(HEIGHT - 1, (int)std::floor(maxY));
+		for (int y = y0; y <= y1; y++)
+		{
+			for (int x = x0; x <= x1; x++)
+			{
+				if (depth[y * WIDTH + x] >= closestDepth) return false;
+			}
+		}
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+#include "mesh.h"
+#include "scenegraph.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Occlusion culling on the CPU, for when the latency of culling on the GPU is a problem. The opaque meshes of a few
+	// large occluders are rasterized into a small depth buffer and the bounds of every other object are tested against
+	// it before anything is drawn, so culled objects never reach the driver. Objects outside the frustum are culled too.
+	// Worker threads clip their share of the occluder triangles to the near plane and bin them into screen tiles, then
+	// rasterize whole tiles four pixels at a time. The buffer holds normalized device depth, which is linear in screen
+	// space, raised by the slope of each triangle to the farthest depth it reaches in a pixel. Coverage is sampled at
+	// pixel centers, so an object peeking out by less than a buffer pixel can be culled.
+	class SoftwareOcclusion
+	{
+	public:
+		static const int WIDTH = 256;
+		static const int HEIGHT = 128;
+		// square tiles the triangles are binned into, a multiple of the four pixels rasterized at once
+		static const int TILE_SIZE = 32;
+		static const int TILES_X = WIDTH / TILE_SIZE;
+		static const int TILES_Y = HEIGHT / TILE_SIZE;
+
+		// counts and CPU time of the last cull
+		struct Statistics
+		{
+			unsigned int occluderTriangles = 0;
+			unsigned int objects = 0;
+			unsigned int outsideFrustum = 0;
+			unsigned int occluded = 0;
+			double setupMilliseconds = 0.0;
+			double rasterMilliseconds = 0.0;
+			double testMilliseconds = 0.0;
+			unsigned int threads = 0;
+		};
+
+		SoftwareOcclusion();
+		~SoftwareOcclusion();
+
+		// the meshes of the node are rasterized as occluders unless their material is alpha tested, not the children
+		void addOccluder(SceneNode* node);
+
+		// rasterizes the occluders and tests the meshes of the scene against them
+		void cull(SceneNode* root, const Matrix4& viewProjection);
+		// draws the meshes that passed the last cull with programOverride instead of their node's program if given
+		void draw(ShaderProgram* programOverride = nullptr);
+
+		const Statistics& getStatistics() const;
+	private:
+		struct Object
+		{
+			Mesh* mesh;
+			ShaderProgram* program;
+			Matrix4 modelMatrix;
+			Matrix3 normalMatrix;
+			// rasterized itself, only culled against the frustum
+			bool occluder;
+		};
+
+		// in buffer pixels and normalized device depth, counterclockwise
+		struct Triangle
+		{
+			float x[3], y[3], z[3];
+		};
+
+		// triangles of an occluder mesh, in the order the workers split them
+		struct OccluderMesh
+		{
+			const Mesh* mesh;
+			Matrix4 modelViewProjection;
+			size_t firstTriangle;
+		};
+
+		void collectObjects(SceneNode* node, ShaderProgram* program);
+		bool isOccluder(SceneNode* node) const;
+		static bool isOpaque(Mesh* mesh);
+		void setupTriangles(unsigned int worker, size_t begin, size_t end);
+		void binTriangle(unsigned int worker, const Vector4* clip);
+		void rasterizeTile(int tile);
+		void rasterizeTriangle(const Triangle& triangle, int tileX, int tileY);
+		bool insideFrustum(const Vector4* corners) const;
+		bool isOccluded(const Vector4* corners) const;
+
+		// runs job on every worker and on the calling thread as worker 0, returns once all are done
+		void runOnWorkers(const std::function<void(unsigned int)>& job);
+		void workerLoop(unsigned int worker);
+
+		std::vector<SceneNode*> occluderNodes;
+		std::vector<OccluderMesh> occluderMeshes;
+		size_t occluderTriangles = 0;
+
+		Matrix4 viewProjection;
+		std::vector<Object> objects;
+		std::vector<const Object*> visibleObjects;
+
+		// per worker and tile the triangles binned into it
+		std::vector<std::vector<Triangle>> bins;
+		std::vector<float> depth;
+		std::atomic<int> nextTile;
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wakeCondition, doneCondition;
+		const std::function<void(unsigned int)>* job = nullptr;
+		unsigned int generation = 0;
+		unsigned int pendingWorkers = 0;
+		bool stopping = false;
+
+		Statistics statistics;
+	};
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "stb_image.h"
 
 #include "meshfactory.h"
+#include "hdrimage.h"
 
 namespace engine
 {
@@ -70,15 +71,6 @@ namespace engine
 	}
 	void Texture2D::loadFromDiskHDR(const std::string& filename) const
 	{
-		int width, height, channels;
-		stbi_set_flip_vertically_on_load(true);
-		float* data = stbi_loadf(filename.c_str(), &width, &height, &channels, 0);
-
-		if (data == nullptr)
-		{
-			throw FileCouldNotBeOpenedException(filename.c_str());
-		}
-
 		glBindTexture(GL_TEXTURE_2D, id);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -86,10 +78,42 @@ namespace engine
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
+		// Radiance files are decoded multithreaded straight to half floats, everything else goes through stb
+		HdrImage image;
+		if (loadRadianceHDR(filename, image))
+		{
+			// rows of 3 half floats are only 2 byte aligned
+			GLint unpackAlignment;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, image.width, image.height, 0, GL_RGB, GL_HALF_FLOAT, image.data.data());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+		}
+		else
+		{
+			int width, height, channels;
+			stbi_set_flip_vertically_on_load(true);
+			float* data = stbi_loadf(filename.c_str(), &width, &height, &channels, 3);
+
+			if (data == nullptr)
+			{
+				glBindTexture(GL_TEXTURE_2D, 0);
+				throw FileCouldNotBeOpenedException(filename.c_str());
+			}
+
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
+			stbi_image_free(data);
+		}
 
 		glBindTexture(GL_TEXTURE_2D, 0);
-		stbi_image_free(data);
+	}
+	bool Texture2D::hasAlphaChannel() const
+	{
+		GLint alphaSize = 0;
+		bind();
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_ALPHA_SIZE, &alphaSize);
+		unbind();
+		return alphaSize > 0;
 	}
 	void Texture2D::createFromColorGrayscale(float color) const
 	{
@@ -146,7 +170,7 @@ namespace engine
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, id, 0);
 
 		ShaderProgram* program = new ShaderProgram();
-		program->init("shaders/general/quad2D.vert", "shaders/preprocessing/brdfLUT.frag");
+		program->init("shaders/preprocessing/brdfLUT.vert", "shaders/preprocessing/brdfLUT.frag");
 		program->link();
 
 		program->use();
@@ -34,6 +34,8 @@ namespace engine
 		void createFromColorGrayscale(float color) const;
 		void createFromColorRGB(const Vector3& color) const;
 		void createBRDFLookupTexture() const;
+		// whether the image had an alpha channel, e.g. cut out foliage
+		bool hasAlphaChannel() const;
 	};
 
 	class TextureCubemap : public Texture
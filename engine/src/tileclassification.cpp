@@ -0,0 +1,134 @@
+#include "tileclassification.h"
+
+namespace engine
+{
+	// the draw commands of the lists are followed by their dispatch commands
+	const GLintptr DRAW_COMMAND_SIZE = 4 * sizeof(GLuint);
+	const GLintptr DISPATCH_COMMAND_SIZE = 3 * sizeof(GLuint);
+	const GLintptr DISPATCH_COMMANDS_OFFSET = TileClassification::TILE_LIST_COUNT * DRAW_COMMAND_SIZE;
+	// binding point of the commands while the pass counts the tiles, the lists are bound at TILE_BUFFER_BP
+	const GLuint COMMAND_BUFFER_BP = TileClassification::TILE_BUFFER_BP + 1;
+
+	TileClassification::TileClassification(const GBuffer* gbuffer, const ScreenViewport* viewport) : gbuffer(gbuffer), viewport(viewport)
+	{
+		std::vector<std::string> defines = getShaderDefines();
+		defines.push_back("DISPATCH_GROUP_SIZE " + std::to_string(DISPATCH_GROUP_SIZE));
+		std::vector<std::string> gbufferDefines = gbuffer->getShaderDefines();
+		defines.insert(defines.end(), gbufferDefines.begin(), gbufferDefines.end());
+
+		program = new ShaderProgram();
+		program->initCompute("shaders/general/tileClassify.comp", defines);
+		program->link();
+		gbuffer->updateShader(program);
+
+		glGenVertexArrays(1, &emptyVao);
+	}
+
+	TileClassification::~TileClassification()
+	{
+		deleteBufferData();
+		glDeleteVertexArrays(1, &emptyVao);
+		delete program;
+	}
+
+	std::vector<std::string> TileClassification::getShaderDefines()
+	{
+		return { "CLASSIFICATION_TILE_SIZE " + std::to_string(TILE_SIZE) };
+	}
+
+	void TileClassification::initialize(unsigned int windowWidth, unsigned int windowHeight)
+	{
+		tileCountX = (windowWidth + TILE_SIZE - 1) / TILE_SIZE;
+		tileCountY = (windowHeight + TILE_SIZE - 1) / TILE_SIZE;
+
+		glGenTextures(1, &flagsTexture);
+		glBindTexture(GL_TEXTURE_2D, flagsTexture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8UI, tileCountX, tileCountY);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// every list can hold all tiles, the lists are bound as ranges that have to be aligned
+		GLint alignment = 256;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		listStride = ((GLsizeiptr)tileCountX * tileCountY * sizeof(GLuint) + alignment - 1) / alignment * alignment;
+		glGenBuffers(1, &tileBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, listStride * TILE_LIST_COUNT, nullptr, GL_DYNAMIC_COPY);
+
+		glGenBuffers(1, &commandBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, DISPATCH_COMMANDS_OFFSET + TILE_LIST_COUNT * DISPATCH_COMMAND_SIZE, nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	void TileClassification::deleteBufferData()
+	{
+		if (flagsTexture != 0)
+		{
+			glDeleteTextures(1, &flagsTexture);
+			flagsTexture = 0;
+		}
+		if (tileBuffer != 0)
+		{
+			glDeleteBuffers(1, &tileBuffer);
+			glDeleteBuffers(1, &commandBuffer);
+			tileBuffer = 0;
+			commandBuffer = 0;
+		}
+	}
+
+	void TileClassification::classify()
+	{
+		// empty lists: six vertices of no instances and no tiles of groups, the pass counts the tiles up. The groups of a
+		// tile are the second dimension of the dispatch, so large screens stay below the limit of groups per dimension
+		const GLuint groupsPerTile = (TILE_SIZE / DISPATCH_GROUP_SIZE) * (TILE_SIZE / DISPATCH_GROUP_SIZE);
+		GLuint commands[TILE_LIST_COUNT * 7];
+		for (unsigned int list = 0; list < TILE_LIST_COUNT; list++)
+		{
+			GLuint* draw = commands + list * 4;
+			draw[0] = 6; draw[1] = 0; draw[2] = 0; draw[3] = 0;
+			GLuint* dispatch = commands + TILE_LIST_COUNT * 4 + list * 3;
+			dispatch[0] = 0; dispatch[1] = groupsPerTile; dispatch[2] = 1;
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(commands), commands);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		gbuffer->bindTextures();
+		glBindImageTexture(0, flagsTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BUFFER_BP, commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_BUFFER_BP, tileBuffer);
+
+		program->use();
+		program->setUniform("listStride", (int)(listStride / sizeof(GLuint)));
+		glDispatchCompute((viewport->getWidth() + TILE_SIZE - 1) / TILE_SIZE, (viewport->getHeight() + TILE_SIZE - 1) / TILE_SIZE, 1);
+		program->unuse();
+
+		// the commands are read by indirect draws and dispatches, the lists by their shaders
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+
+	void TileClassification::bindList(TileList list) const
+	{
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, TILE_BUFFER_BP, tileBuffer, list * listStride, listStride);
+	}
+
+	void TileClassification::drawTiles(TileList list) const
+	{
+		bindList(list);
+		glBindVertexArray(emptyVao);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glDrawArraysIndirect(GL_TRIANGLES, (const void*)(list * DRAW_COMMAND_SIZE));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	void TileClassification::dispatchTiles(TileList list) const
+	{
+		bindList(list);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, commandBuffer);
+		glDispatchComputeIndirect(DISPATCH_COMMANDS_OFFSET + list * DISPATCH_COMMAND_SIZE);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	}
+}
\ No newline at end of file
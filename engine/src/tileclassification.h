@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "geometrybuffer.h"
+#include "screenviewport.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Sorts the screen tiles by what the GBuffer holds in them, so screen space passes only run where they have work.
+	// A compute pass flags every tile as holding sky, geometry and reflective pixels, then appends the tiles with
+	// geometry and with reflective pixels to lists along with indirect draw and dispatch commands. Fragment passes draw
+	// a quad per listed tile through tile.vert instead of a full screen quad, compute passes with 8x8 groups dispatch
+	// the groups of the listed tiles. Tiles that are only sky are in neither list.
+	class TileClassification
+	{
+	public:
+		static const unsigned int TILE_SIZE = 16;
+		// the indirect dispatches are made of groups this large
+		static const unsigned int DISPATCH_GROUP_SIZE = 8;
+		// shader storage binding point of the tile lists, fixed in the shaders
+		static const GLuint TILE_BUFFER_BP = 5;
+
+		enum TileFlag { TILE_SKY = 1, TILE_GEOMETRY = 2, TILE_REFLECTIVE = 4 };
+		enum TileList { GEOMETRY_TILES, REFLECTIVE_TILES, TILE_LIST_COUNT };
+
+		// the pass decodes the metallic channel of the current layout of gbuffer, create a new instance when it changes
+		TileClassification(const GBuffer* gbuffer, const ScreenViewport* viewport);
+		~TileClassification();
+
+		// allocates the flags and lists of the tiles of targets this large
+		void initialize(unsigned int windowWidth, unsigned int windowHeight);
+		void deleteBufferData();
+
+		// classifies the tiles of the viewport from the GBuffer
+		void classify();
+		// draws the tiles of a list with the bound program, whose vertex shader has to be tile.vert
+		void drawTiles(TileList list) const;
+		// dispatches the DISPATCH_GROUP_SIZE groups covering the tiles of a list with the bound compute program, the x
+		// group index is the index of the tile in the list and the y index the group inside the tile
+		void dispatchTiles(TileList list) const;
+
+		// defines of the shaders reading the tile lists
+		static std::vector<std::string> getShaderDefines();
+
+		// TileFlag bits per tile in a GL_R8UI texture
+		GLuint flagsTexture = 0;
+		unsigned int tileCountX = 0, tileCountY = 0;
+	private:
+		void bindList(TileList list) const;
+
+		const GBuffer* gbuffer;
+		const ScreenViewport* viewport;
+		ShaderProgram* program = nullptr;
+
+		// tile coordinates of every list, each starts at a multiple of listStride bytes
+		GLuint tileBuffer = 0;
+		GLsizeiptr listStride = 0;
+		// a draw command for each list followed by a dispatch command for each list
+		GLuint commandBuffer = 0;
+		// no vertex data, tile.vert builds the quads from the vertex and instance index
+		GLuint emptyVao = 0;
+	};
+}
\ No newline at end of file
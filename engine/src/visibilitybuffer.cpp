@@ -0,0 +1,235 @@
+#include "visibilitybuffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "meshfactory.h"
+
+namespace engine
+{
+	// matches the std430 layout of DrawRecord in visibility.glsl
+	struct GpuDraw
+	{
+		float modelMatrix[16];
+		float normalMatrix[16];
+		uint32_t mesh;
+		uint32_t padding[3];
+	};
+
+	// texture unit of the id texture, the material textures use units 0 to 4
+	const int ID_TEXTURE_UNIT = 5;
+
+	static std::vector<std::string> getShaderDefines()
+	{
+		return {
+			"TRIANGLE_BITS " + std::to_string(VisibilityBuffer::TRIANGLE_BITS),
+			"MAX_MESHES " + std::to_string(VisibilityBuffer::MAX_MESHES),
+			"VERTEX_STRIDE " + std::to_string(sizeof(Vertex) / sizeof(float)),
+			"TEXCOORD_OFFSET " + std::to_string(offsetof(Vertex, texcoords) / sizeof(float)),
+			"NORMAL_OFFSET " + std::to_string(offsetof(Vertex, normal) / sizeof(float)),
+			"TANGENT_OFFSET " + std::to_string(offsetof(Vertex, tangent) / sizeof(float))
+		};
+	}
+
+	VisibilityBuffer::VisibilityBuffer(const Camera* camera, const GBuffer* gbuffer) : gbuffer(gbuffer)
+	{
+		quad = MeshFactory::createQuad();
+		std::vector<std::string> defines = getShaderDefines();
+
+		idProgram = new ShaderProgram();
+		idProgram->init("shaders/general/visibility.vert", "shaders/general/visibility.frag", defines);
+		idProgram->link();
+		idProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+
+		classifyProgram = new ShaderProgram();
+		classifyProgram->init("shaders/general/quad2D.vert", "shaders/general/visibilityClassify.frag", defines);
+		classifyProgram->link();
+
+		std::vector<std::string> gbufferDefines = gbuffer->getShaderDefines();
+		defines.insert(defines.end(), gbufferDefines.begin(), gbufferDefines.end());
+
+		resolveProgram = new ShaderProgram();
+		resolveProgram->init("shaders/general/visibilityResolve.vert", "shaders/general/visibilityResolve.frag", defines);
+		resolveProgram->link();
+		resolveProgram->setUniformBlockBinding("SharedMatrices", camera->getUboBP());
+
+		for (ShaderProgram* program : { classifyProgram, resolveProgram })
+		{
+			program->use();
+			program->setUniform("visibilityIds", ID_TEXTURE_UNIT);
+			program->unuse();
+		}
+
+		glGenBuffers(1, &drawBuffer);
+	}
+
+	VisibilityBuffer::~VisibilityBuffer()
+	{
+		deleteBufferData();
+		glDeleteBuffers(1, &drawBuffer);
+		delete quad;
+		delete idProgram;
+		delete classifyProgram;
+		delete resolveProgram;
+	}
+
+	void VisibilityBuffer::initialize(unsigned int windowWidth, unsigned int windowHeight)
+	{
+		// ids and the GBuffer depth
+		glGenFramebuffers(1, &fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, windowWidth, windowHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, gbuffer->depthTexture, 0);
+
+		// GBuffer color targets and the per pixel mesh depth, float so the equal test is exact
+		glGenFramebuffers(1, &resolveFbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, resolveFbo);
+		glGenTextures(1, &meshDepthTexture);
+		glBindTexture(GL_TEXTURE_2D, meshDepthTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, windowWidth, windowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, meshDepthTexture, 0);
+
+		GLenum drawBuffers[GBuffer::GB_NUMBER_OF_TEXTURES];
+		for (unsigned int i = 0; i < GBuffer::GB_NUMBER_OF_TEXTURES; i++)
+		{
+			drawBuffers[i] = gbuffer->getLayout().formats[i] != 0 ? GL_COLOR_ATTACHMENT0 + i : GL_NONE;
+			if (drawBuffers[i] != GL_NONE)
+			{
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, gbuffer->texture[i], 0);
+			}
+		}
+		glDrawBuffers(GBuffer::GB_NUMBER_OF_TEXTURES, drawBuffers);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void VisibilityBuffer::deleteBufferData()
+	{
+		if (texture != 0)
+			glDeleteTextures(1, &texture);
+		if (meshDepthTexture != 0)
+			glDeleteTextures(1, &meshDepthTexture);
+		if (fbo != 0)
+			glDeleteFramebuffers(1, &fbo);
+		if (resolveFbo != 0)
+			glDeleteFramebuffers(1, &resolveFbo);
+	}
+
+	void VisibilityBuffer::collectDraws(SceneNode* node)
+	{
+		IDrawable* drawable = node->getDrawable();
+		if (drawable != nullptr)
+		{
+			Matrix4 modelMatrix = node->getModelMatrix();
+			for (Mesh* mesh : drawable->getMeshes())
+			{
+				unsigned int meshIndex = (unsigned int)(std::find(meshes.begin(), meshes.end(), mesh) - meshes.begin());
+				if (meshIndex == meshes.size())
+				{
+					// the mesh depth only distinguishes MAX_MESHES meshes
+					if (meshes.size() == MAX_MESHES) continue;
+					meshes.push_back(mesh);
+				}
+
+				if (draws.size() == MAX_DRAWS) return;
+				draws.push_back({ mesh, modelMatrix, meshIndex });
+			}
+		}
+
+		for (SceneNode* child : node->getNodes())
+		{
+			collectDraws(child);
+		}
+	}
+
+	void VisibilityBuffer::uploadDraws()
+	{
+		std::vector<GpuDraw> gpuDraws(draws.size());
+		for (size_t i = 0; i < draws.size(); i++)
+		{
+			Matrix4 normalMatrix = Matrix4(Matrix3(draws[i].modelMatrix).inversed().transposed());
+			std::memcpy(gpuDraws[i].modelMatrix, draws[i].modelMatrix.data, sizeof(gpuDraws[i].modelMatrix));
+			std::memcpy(gpuDraws[i].normalMatrix, normalMatrix.data, sizeof(gpuDraws[i].normalMatrix));
+			gpuDraws[i].mesh = draws[i].meshIndex;
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, gpuDraws.size() * sizeof(GpuDraw), gpuDraws.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_BUFFER_BP, drawBuffer);
+	}
+
+	void VisibilityBuffer::render(SceneNode* root)
+	{
+		draws.clear();
+		meshes.clear();
+		collectDraws(root);
+		uploadDraws();
+
+		// background of the color targets as the regular geometry pass leaves it
+		glBindFramebuffer(GL_FRAMEBUFFER, gbuffer->fbo);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		// id pass, only positions are transformed and nothing but alpha tested albedo is sampled, overdraw is cheap
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		const GLuint emptyId[4] = { 0xFFFFFFFF, 0, 0, 0 };
+		glClearBufferuiv(GL_COLOR, 0, emptyId);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		idProgram->use();
+		for (size_t i = 0; i < draws.size(); i++)
+		{
+			idProgram->setUniform("ModelMatrix", draws[i].modelMatrix);
+			idProgram->setUniform("drawIndex", (int)i);
+			// only the alpha test reads the material
+			if (draws[i].mesh->getMaterial())
+			{
+				draws[i].mesh->getMaterial()->bind(idProgram);
+			}
+			draws[i].mesh->drawInstanced(1);
+		}
+		idProgram->unuse();
+
+		// classification, the mesh of every covered pixel becomes its depth
+		glBindFramebuffer(GL_FRAMEBUFFER, resolveFbo);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glActiveTexture(GL_TEXTURE0 + ID_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, texture);
+
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthFunc(GL_ALWAYS);
+		classifyProgram->use();
+		quad->draw();
+		classifyProgram->unuse();
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		// resolve, one quad per mesh shades only the pixels of that mesh, each exactly once
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+		resolveProgram->use();
+		for (unsigned int i = 0; i < meshes.size(); i++)
+		{
+			meshes[i]->bindStorageBuffers(VERTEX_BUFFER_BP, INDEX_BUFFER_BP);
+			if (meshes[i]->getMaterial())
+			{
+				meshes[i]->getMaterial()->bind(resolveProgram);
+			}
+			resolveProgram->setUniform("meshIndex", (int)i);
+			quad->draw();
+		}
+		resolveProgram->unuse();
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LEQUAL);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, gbuffer->fbo);
+	}
+}
\ No newline at end of file
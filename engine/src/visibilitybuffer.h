@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "camera.h"
+#include "geometrybuffer.h"
+#include "mesh.h"
+#include "scenegraph.h"
+#include "shader.h"
+
+namespace engine
+{
+	// Alternative geometry pass that decouples material cost from overdraw. The scene is rasterized into a 32 bit
+	// draw/triangle id plus depth only, then every pixel fetches its triangle from the mesh buffers, interpolates
+	// the vertex attributes and samples its material exactly once while writing the GBuffer color targets.
+	// Without bindless textures the resolve runs once per mesh: a classification pass writes each pixel's mesh as depth
+	// and a full screen quad per mesh is depth tested with GL_EQUAL against it, with that mesh's material bound.
+	class VisibilityBuffer
+	{
+	public:
+		// lower bits of an id hold the triangle, the upper bits the draw, meshes may have up to 2^TRIANGLE_BITS triangles
+		static const unsigned int TRIANGLE_BITS = 20;
+		// the all ones id marks pixels without geometry
+		static const unsigned int MAX_DRAWS = (1 << (32 - TRIANGLE_BITS)) - 1;
+		static const unsigned int MAX_MESHES = 1023;
+
+		// shader storage binding points of the draw records and the mesh being resolved, fixed in the shaders
+		static const GLuint DRAW_BUFFER_BP = 2;
+		static const GLuint VERTEX_BUFFER_BP = 3;
+		static const GLuint INDEX_BUFFER_BP = 4;
+
+		// the resolve program encodes the current layout of gbuffer, create a new instance when it changes
+		VisibilityBuffer(const Camera* camera, const GBuffer* gbuffer);
+		~VisibilityBuffer();
+
+		// shares the depth texture and color targets of the GBuffer, call again after it was reinitialized
+		void initialize(unsigned int windowWidth, unsigned int windowHeight);
+		void deleteBufferData();
+
+		// fills the GBuffer depth and color targets, replaces drawing the scene into the GBuffer
+		void render(SceneNode* root);
+
+		GLuint fbo = 0;
+		GLuint texture = 0;
+		GLuint resolveFbo = 0;
+		GLuint meshDepthTexture = 0;
+	private:
+		struct Draw
+		{
+			Mesh* mesh;
+			Matrix4 modelMatrix;
+			unsigned int meshIndex;
+		};
+
+		void collectDraws(SceneNode* node);
+		void uploadDraws();
+
+		const GBuffer* gbuffer;
+		std::vector<Draw> draws;
+		// meshes in resolve order, collected with the draws every frame
+		std::vector<Mesh*> meshes;
+
+		GLuint drawBuffer = 0;
+		Mesh* quad = nullptr;
+		ShaderProgram* idProgram = nullptr;
+		ShaderProgram* classifyProgram = nullptr;
+		ShaderProgram* resolveProgram = nullptr;
+	};
+}
\ No newline at end of file